@@ -0,0 +1,1240 @@
+#pragma once
+
+#include <vector>
+#include <span>
+#include <deque>
+#include <cfloat>
+#include <algorithm>
+#include <numeric>
+#include <execution>
+#include <bit>
+#include <cmath>
+
+#include "Vector3.hpp"
+
+enum class BVHLayout
+{
+	binary,
+	wide,
+	quantized
+};
+
+enum class BVHBuildQuality
+{
+	//	LBVH over Morton codes, for geometry that has to be rebuilt interactively
+	linear,
+	//	binned SAH over whole primitives
+	fast,
+	//	also considers splitting primitives at spatial split planes, slower to build but traces faster through long, thin primitives
+	spatialSplits
+};
+
+//	Spatial split builds stop splitting once there are this many times more primitive references than primitives
+constexpr float SPATIAL_SPLIT_REFERENCE_GROWTH_LIMIT{ 1.5f };
+
+//	Uncomment to traverse the triangle mesh BVHs with the quantized wide nodes instead of the full precision ones
+//#define QUANTIZED_BVH
+
+#ifdef QUANTIZED_BVH
+constexpr BVHLayout DEFAULT_BVH_LAYOUT{ BVHLayout::quantized };
+#else
+constexpr BVHLayout DEFAULT_BVH_LAYOUT{ BVHLayout::wide };
+#endif
+
+struct AABB
+{
+public:
+	bool operator==(const AABB& aabb) const = default;
+
+	inline void Grow(const Vector3& point)
+	{
+		smallest = Vector3::GetSmallestComponents(point, smallest);
+		largest = Vector3::GetLargestComponents(point, largest);
+	}
+
+	inline void Grow(const AABB& aabb)
+	{
+		smallest = Vector3::GetSmallestComponents(aabb.smallest, smallest);
+		largest = Vector3::GetLargestComponents(aabb.largest, largest);
+	}
+
+	//	Shrinks to the overlap with the given bounds, which leaves an empty box when they don't overlap
+	inline void Intersect(const AABB& aabb)
+	{
+		smallest = Vector3::GetLargestComponents(aabb.smallest, smallest);
+		largest = Vector3::GetSmallestComponents(aabb.largest, largest);
+	}
+
+	inline bool IsEmpty() const
+	{
+		return smallest.x > largest.x || smallest.y > largest.y || smallest.z > largest.z;
+	}
+
+	inline Vector3 GetCentroid() const
+	{
+		return (smallest + largest) * 0.5f;
+	}
+
+	inline float GetSurfaceArea() const
+	{
+		const Vector3 extent{ largest - smallest };
+		return extent.x * extent.y + extent.y * extent.z + extent.z * extent.x;
+	}
+
+	Vector3
+		smallest{ FLT_MAX, FLT_MAX, FLT_MAX },
+		largest{ -FLT_MAX, -FLT_MAX, -FLT_MAX };
+};
+
+struct BVHNode
+{
+public:
+	inline bool IsLeaf() const
+	{
+		return primitiveAmount > 0;
+	}
+
+	AABB bounds;
+
+	//	index of the left child (the right child directly follows it) for internal nodes, index of the first primitive index for leaves
+	int leftFirst;
+	int primitiveAmount;
+};
+
+//	Four children tested at once, the bounds are stored per axis so they can be loaded straight into SSE registers
+struct alignas(64) WideBVHNode
+{
+public:
+	float
+		aSmallestX[4],
+		aSmallestY[4],
+		aSmallestZ[4],
+		aLargestX[4],
+		aLargestY[4],
+		aLargestZ[4];
+
+	//	index of the child node for internal children, index of the first primitive index for leaves
+	int aChildIndices[4];
+
+	//	0 for internal children, -1 for unused slots
+	int aPrimitiveAmounts[4];
+};
+
+//	Same hierarchy as WideBVHNode in a single cache line: the child bounds are stored in 8 bits on a power of two grid
+//	relative to the smallest corner of the node, rounded outwards so a quantized box always contains the original one
+struct alignas(64) QuantizedWideBVHNode
+{
+public:
+	static constexpr unsigned int
+		LEAF_FLAG{ 1u << 31 },
+		PRIMITIVE_AMOUNT_SHIFT{ 24 },
+		FIRST_PRIMITIVE_MASK{ (1u << PRIMITIVE_AMOUNT_SHIFT) - 1 },
+		MAX_PRIMITIVE_AMOUNT{ (~LEAF_FLAG >> PRIMITIVE_AMOUNT_SHIFT) + 1 };
+
+	static inline float GetScale(signed char scaleExponent)
+	{
+		//	-127 gives 0, used for axes on which every child is flat
+		return std::bit_cast<float>(static_cast<unsigned int>(scaleExponent + 127) << 23);
+	}
+
+	static inline bool IsLeaf(unsigned int child)
+	{
+		return child & LEAF_FLAG;
+	}
+
+	static inline int GetFirstPrimitive(unsigned int child)
+	{
+		return static_cast<int>(child & FIRST_PRIMITIVE_MASK);
+	}
+
+	static inline int GetPrimitiveAmount(unsigned int child)
+	{
+		return static_cast<int>((child & ~LEAF_FLAG) >> PRIMITIVE_AMOUNT_SHIFT) + 1;
+	}
+
+	float aOrigin[3];
+	signed char aScaleExponents[3];
+
+	//	bit per used child slot
+	unsigned char usedChildMask;
+
+	unsigned char
+		aSmallestX[4],
+		aSmallestY[4],
+		aSmallestZ[4],
+		aLargestX[4],
+		aLargestY[4],
+		aLargestZ[4];
+
+	//	index of the child node for internal children, LEAF_FLAG | (primitive amount - 1) << PRIMITIVE_AMOUNT_SHIFT | first primitive index for leaves
+	unsigned int aChildren[4];
+};
+
+class BVH final
+{
+public:
+	static constexpr int
+		MAX_DEPTH{ 64 },
+		WIDTH{ 4 },
+		MAX_LEAF_PRIMITIVE_AMOUNT{ 128 },
+		BIN_AMOUNT{ 16 };
+
+	BVH() = default;
+
+	//	Binned SAH build over the bounds of every primitive; the primitives are referenced by their index in vPrimitiveBounds.
+	//	Large nodes get binned in parallel chunks, once the nodes are small enough their subtrees get built in parallel
+	inline void Build(const std::vector<AABB>& vPrimitiveBounds)
+	{
+		if (!InitializeBuild(vPrimitiveBounds))
+			return;
+
+		std::vector<Vector3> vCentroids(vPrimitiveBounds.size());
+		std::transform(std::execution::par, vPrimitiveBounds.begin(), vPrimitiveBounds.end(), vCentroids.begin(),
+			[](const AABB& primitiveBounds) { return primitiveBounds.GetCentroid(); });
+
+		BuildHierarchy(
+			[this, &vPrimitiveBounds, &vCentroids](std::vector<BVHNode>& vNodes, int nodeIndex)
+			{
+				return SplitNodeBinnedSAH(vNodes, nodeIndex, vPrimitiveBounds, vCentroids);
+			});
+	}
+
+	//	LBVH build: the primitives get sorted along a Morton curve through their centroids and every node gets split where the
+	//	highest bit differs between the codes of its primitives. Much faster to build than the SAH, but traces slower
+	inline void BuildLinear(const std::vector<AABB>& vPrimitiveBounds)
+	{
+		if (!InitializeBuild(vPrimitiveBounds))
+			return;
+
+		const AABB centroidBounds
+		{
+			std::transform_reduce(std::execution::par, vPrimitiveBounds.begin(), vPrimitiveBounds.end(), AABB(),
+				[](AABB left, const AABB& right) { left.Grow(right); return left; },
+				[](const AABB& primitiveBounds) { AABB centroidBounds{}; centroidBounds.Grow(primitiveBounds.GetCentroid()); return centroidBounds; })
+		};
+
+		const Vector3 centroidExtent{ centroidBounds.largest - centroidBounds.smallest };
+		const Vector3 centroidScale
+		{
+			centroidExtent.x > 0.0f ? 1023.0f / centroidExtent.x : 0.0f,
+			centroidExtent.y > 0.0f ? 1023.0f / centroidExtent.y : 0.0f,
+			centroidExtent.z > 0.0f ? 1023.0f / centroidExtent.z : 0.0f
+		};
+
+		//	Spreads the lowest 10 bits so two zero bits follow each of them
+		const auto expandBits
+		{
+			[](unsigned int value)
+			{
+				value = (value * 0x00010001u) & 0xFF0000FFu;
+				value = (value * 0x00000101u) & 0x0F00F00Fu;
+				value = (value * 0x00000011u) & 0xC30C30C3u;
+				value = (value * 0x00000005u) & 0x49249249u;
+				return value;
+			}
+		};
+
+		std::vector<unsigned int> vMortonCodes(vPrimitiveBounds.size());
+		std::transform(std::execution::par, vPrimitiveBounds.begin(), vPrimitiveBounds.end(), vMortonCodes.begin(),
+			[&centroidBounds, &centroidScale, &expandBits](const AABB& primitiveBounds)
+			{
+				const Vector3 centroid{ primitiveBounds.GetCentroid() };
+				return
+					expandBits(static_cast<unsigned int>((centroid.x - centroidBounds.smallest.x) * centroidScale.x)) << 2 |
+					expandBits(static_cast<unsigned int>((centroid.y - centroidBounds.smallest.y) * centroidScale.y)) << 1 |
+					expandBits(static_cast<unsigned int>((centroid.z - centroidBounds.smallest.z) * centroidScale.z));
+			});
+
+		SortByMortonCode(vMortonCodes);
+
+		BuildHierarchy(
+			[&vMortonCodes](std::vector<BVHNode>& vNodes, int nodeIndex)
+			{
+				const BVHNode node{ vNodes[nodeIndex] };
+				if (node.primitiveAmount <= 1)
+					return false;
+
+				const int lastIndex{ node.leftFirst + node.primitiveAmount - 1 };
+				const unsigned int differentBits{ vMortonCodes[node.leftFirst] ^ vMortonCodes[lastIndex] };
+
+				//	Primitives with the same code get split in the middle
+				int leftAmount{ node.primitiveAmount / 2 };
+				if (differentBits)
+				{
+					const unsigned int splitBit{ 1u << (31 - std::countl_zero(differentBits)) };
+					leftAmount = static_cast<int>(std::partition_point(vMortonCodes.begin() + node.leftFirst, vMortonCodes.begin() + lastIndex + 1,
+						[splitBit](unsigned int mortonCode) { return !(mortonCode & splitBit); }) - (vMortonCodes.begin() + node.leftFirst));
+				}
+
+				const int leftChildIndex{ static_cast<int>(vNodes.size()) };
+				vNodes.push_back(BVHNode(AABB(), node.leftFirst, leftAmount));
+				vNodes.push_back(BVHNode(AABB(), node.leftFirst + leftAmount, node.primitiveAmount - leftAmount));
+				vNodes[nodeIndex].leftFirst = leftChildIndex;
+				vNodes[nodeIndex].primitiveAmount = 0;
+				return true;
+			});
+
+		Refit(vPrimitiveBounds);
+	}
+
+	//	SBVH build: besides the binned object splits, references to primitives can get split at spatial split planes when the
+	//	children of the best object split overlap; a split reference is clipped by clipPrimitive(primitiveIndex, axis, position, leftBounds, rightBounds),
+	//	which grows the (empty) bounds with the part of the primitive on either side of the plane.
+	//	Splitting stops once there are referenceGrowthLimit times more references than primitives, leaves can reference the same primitive
+	template<typename ClipPrimitiveFunction>
+	inline void BuildWithSpatialSplits(const std::vector<AABB>& vPrimitiveBounds, float referenceGrowthLimit, ClipPrimitiveFunction clipPrimitive)
+	{
+		//	Only overlaps larger than this fraction of the root surface area are worth trying a spatial split for
+		static constexpr float SPATIAL_SPLIT_OVERLAP_THRESHOLD{ 1e-5f };
+
+		struct Reference
+		{
+			AABB bounds;
+			int primitiveIndex;
+		};
+
+		struct Task
+		{
+			int
+				nodeIndex,
+				depth;
+
+			std::vector<Reference> vReferences;
+		};
+
+		m_vNodes.clear();
+		m_vPrimitiveIndices.clear();
+		if (vPrimitiveBounds.empty())
+			return;
+
+		const int primitiveAmount{ static_cast<int>(vPrimitiveBounds.size()) };
+		Task rootTask{ 0, 0, std::vector<Reference>(vPrimitiveBounds.size()) };
+		AABB rootBounds{};
+		for (int index{}; index < vPrimitiveBounds.size(); ++index)
+		{
+			rootTask.vReferences[index] = Reference(vPrimitiveBounds[index], index);
+			rootBounds.Grow(vPrimitiveBounds[index]);
+		}
+
+		const float minimumOverlap{ SPATIAL_SPLIT_OVERLAP_THRESHOLD * rootBounds.GetSurfaceArea() };
+
+		//	References that may still be added by splitting
+		int splitBudget{ std::max(0, static_cast<int>(referenceGrowthLimit * primitiveAmount) - primitiveAmount) };
+
+		//	Clips a reference at the plane and keeps both parts inside the bounds the reference already had
+		const auto splitReference
+		{
+			[&clipPrimitive](const Reference& reference, int axis, float position, Reference& leftReference, Reference& rightReference)
+			{
+				leftReference = Reference(AABB(), reference.primitiveIndex);
+				rightReference = Reference(AABB(), reference.primitiveIndex);
+				clipPrimitive(reference.primitiveIndex, axis, position, leftReference.bounds, rightReference.bounds);
+
+				leftReference.bounds.Intersect(reference.bounds);
+				leftReference.bounds.largest[axis] = std::min(leftReference.bounds.largest[axis], position);
+				rightReference.bounds.Intersect(reference.bounds);
+				rightReference.bounds.smallest[axis] = std::max(rightReference.bounds.smallest[axis], position);
+			}
+		};
+
+		m_vNodes.reserve(2 * vPrimitiveBounds.size());
+		m_vNodes.push_back(BVHNode(rootBounds, 0, 0));
+		m_vPrimitiveIndices.reserve(primitiveAmount + splitBudget);
+
+		//	Built breadth first, so the splits near the root where they pay off most get the memory before the deeper levels
+		std::deque<Task> vTasks{};
+		vTasks.push_back(std::move(rootTask));
+		while (!vTasks.empty())
+		{
+			const Task task{ std::move(vTasks.front()) };
+			vTasks.pop_front();
+
+			const std::vector<Reference>& vReferences{ task.vReferences };
+			const AABB nodeBounds{ m_vNodes[task.nodeIndex].bounds };
+			const int nodeReferenceAmount{ static_cast<int>(vReferences.size()) };
+
+			const auto makeLeaf
+			{
+				[this, &task, &vReferences]()
+				{
+					m_vNodes[task.nodeIndex].leftFirst = static_cast<int>(m_vPrimitiveIndices.size());
+					m_vNodes[task.nodeIndex].primitiveAmount = static_cast<int>(vReferences.size());
+					for (const Reference& reference : vReferences)
+						m_vPrimitiveIndices.push_back(reference.primitiveIndex);
+				}
+			};
+
+			if (nodeReferenceAmount <= 1 || task.depth >= MAX_DEPTH - 1)
+			{
+				makeLeaf();
+				continue;
+			}
+
+			AABB centroidBounds{};
+			for (const Reference& reference : vReferences)
+				centroidBounds.Grow(reference.bounds.GetCentroid());
+
+			//	Object split
+			int
+				bestObjectAxis{ -1 },
+				bestObjectSplit{};
+			float bestObjectCost{ FLT_MAX };
+			AABB
+				bestObjectLeftBounds{},
+				bestObjectRightBounds{};
+
+			for (int axis{}; axis < 3; ++axis)
+			{
+				const float
+					smallestCentroid{ centroidBounds.smallest[axis] },
+					largestCentroid{ centroidBounds.largest[axis] };
+
+				if (smallestCentroid == largestCentroid)
+					continue;
+
+				struct Bin
+				{
+					AABB bounds;
+					int referenceAmount;
+				};
+
+				Bin aBins[BIN_AMOUNT]{};
+				const float binScale{ BIN_AMOUNT / (largestCentroid - smallestCentroid) };
+				for (const Reference& reference : vReferences)
+				{
+					Bin& bin{ aBins[std::min(BIN_AMOUNT - 1, static_cast<int>((reference.bounds.GetCentroid()[axis] - smallestCentroid) * binScale))] };
+					bin.bounds.Grow(reference.bounds);
+					++bin.referenceAmount;
+				}
+
+				AABB aLeftBounds[BIN_AMOUNT - 1];
+				int aLeftAmounts[BIN_AMOUNT - 1];
+				AABB leftBounds{};
+				int leftAmount{};
+				for (int index{}; index < BIN_AMOUNT - 1; ++index)
+				{
+					leftBounds.Grow(aBins[index].bounds);
+					leftAmount += aBins[index].referenceAmount;
+					aLeftBounds[index] = leftBounds;
+					aLeftAmounts[index] = leftAmount;
+				}
+
+				AABB rightBounds{};
+				int rightAmount{};
+				for (int index{ BIN_AMOUNT - 1 }; index > 0; --index)
+				{
+					rightBounds.Grow(aBins[index].bounds);
+					rightAmount += aBins[index].referenceAmount;
+
+					if (!aLeftAmounts[index - 1] || !rightAmount)
+						continue;
+
+					const float cost{ aLeftAmounts[index - 1] * aLeftBounds[index - 1].GetSurfaceArea() + rightAmount * rightBounds.GetSurfaceArea() };
+					if (cost < bestObjectCost)
+					{
+						bestObjectCost = cost;
+						bestObjectAxis = axis;
+						bestObjectSplit = index;
+						bestObjectLeftBounds = aLeftBounds[index - 1];
+						bestObjectRightBounds = rightBounds;
+					}
+				}
+			}
+
+			//	Spatial split, only when the object split children overlap and there is memory left for more references
+			int
+				bestSpatialAxis{ -1 },
+				bestSpatialSplit{};
+			float bestSpatialCost{ FLT_MAX };
+
+			AABB overlap{ bestObjectLeftBounds };
+			overlap.Intersect(bestObjectRightBounds);
+			if (splitBudget > 0 && (bestObjectAxis == -1 || (!overlap.IsEmpty() && overlap.GetSurfaceArea() > minimumOverlap)))
+			{
+				for (int axis{}; axis < 3; ++axis)
+				{
+					const float
+						nodeSmallest{ nodeBounds.smallest[axis] },
+						binWidth{ (nodeBounds.largest[axis] - nodeSmallest) / BIN_AMOUNT };
+
+					if (binWidth <= 0.0f)
+						continue;
+
+					struct SpatialBin
+					{
+						AABB bounds;
+						int
+							entryAmount,
+							exitAmount;
+					};
+
+					SpatialBin aBins[BIN_AMOUNT]{};
+					for (const Reference& reference : vReferences)
+					{
+						const int
+							firstBin{ std::clamp(static_cast<int>((reference.bounds.smallest[axis] - nodeSmallest) / binWidth), 0, BIN_AMOUNT - 1) },
+							lastBin{ std::clamp(static_cast<int>((reference.bounds.largest[axis] - nodeSmallest) / binWidth), firstBin, BIN_AMOUNT - 1) };
+
+						Reference remainder{ reference };
+						for (int bin{ firstBin }; bin < lastBin; ++bin)
+						{
+							Reference
+								leftReference,
+								rightReference;
+							splitReference(remainder, axis, nodeSmallest + (bin + 1) * binWidth, leftReference, rightReference);
+							if (!leftReference.bounds.IsEmpty())
+								aBins[bin].bounds.Grow(leftReference.bounds);
+
+							remainder = rightReference;
+						}
+
+						if (!remainder.bounds.IsEmpty())
+							aBins[lastBin].bounds.Grow(remainder.bounds);
+
+						++aBins[firstBin].entryAmount;
+						++aBins[lastBin].exitAmount;
+					}
+
+					float aLeftAreas[BIN_AMOUNT - 1];
+					int aLeftAmounts[BIN_AMOUNT - 1];
+					AABB leftBounds{};
+					int leftAmount{};
+					for (int index{}; index < BIN_AMOUNT - 1; ++index)
+					{
+						leftBounds.Grow(aBins[index].bounds);
+						leftAmount += aBins[index].entryAmount;
+						aLeftAreas[index] = leftAmount ? leftBounds.GetSurfaceArea() : 0.0f;
+						aLeftAmounts[index] = leftAmount;
+					}
+
+					AABB rightBounds{};
+					int rightAmount{};
+					for (int index{ BIN_AMOUNT - 1 }; index > 0; --index)
+					{
+						rightBounds.Grow(aBins[index].bounds);
+						rightAmount += aBins[index].exitAmount;
+
+						if (!aLeftAmounts[index - 1] || !rightAmount || aLeftAmounts[index - 1] + rightAmount - nodeReferenceAmount > splitBudget)
+							continue;
+
+						const float cost{ aLeftAmounts[index - 1] * aLeftAreas[index - 1] + rightAmount * rightBounds.GetSurfaceArea() };
+						if (cost < bestSpatialCost)
+						{
+							bestSpatialCost = cost;
+							bestSpatialAxis = axis;
+							bestSpatialSplit = index;
+						}
+					}
+				}
+			}
+
+			std::vector<Reference>
+				vLeftReferences{},
+				vRightReferences{};
+
+			const float leafCost{ nodeReferenceAmount * nodeBounds.GetSurfaceArea() };
+			if (bestSpatialCost < bestObjectCost && bestSpatialCost < leafCost)
+			{
+				const float
+					nodeSmallest{ nodeBounds.smallest[bestSpatialAxis] },
+					position{ nodeSmallest + bestSpatialSplit * (nodeBounds.largest[bestSpatialAxis] - nodeSmallest) / BIN_AMOUNT };
+
+				for (const Reference& reference : vReferences)
+				{
+					if (reference.bounds.largest[bestSpatialAxis] <= position)
+						vLeftReferences.push_back(reference);
+					else if (reference.bounds.smallest[bestSpatialAxis] >= position)
+						vRightReferences.push_back(reference);
+					else
+					{
+						Reference
+							leftReference,
+							rightReference;
+						splitReference(reference, bestSpatialAxis, position, leftReference, rightReference);
+						if (!leftReference.bounds.IsEmpty())
+							vLeftReferences.push_back(leftReference);
+
+						if (!rightReference.bounds.IsEmpty())
+							vRightReferences.push_back(rightReference);
+					}
+				}
+
+				splitBudget -= static_cast<int>(vLeftReferences.size() + vRightReferences.size() - vReferences.size());
+
+			}
+			else if (bestObjectAxis != -1 && bestObjectCost < leafCost)
+			{
+				const float
+					smallestCentroid{ centroidBounds.smallest[bestObjectAxis] },
+					binScale{ BIN_AMOUNT / (centroidBounds.largest[bestObjectAxis] - smallestCentroid) };
+
+				for (const Reference& reference : vReferences)
+				{
+					if (std::min(BIN_AMOUNT - 1, static_cast<int>((reference.bounds.GetCentroid()[bestObjectAxis] - smallestCentroid) * binScale)) < bestObjectSplit)
+						vLeftReferences.push_back(reference);
+					else
+						vRightReferences.push_back(reference);
+				}
+			}
+
+			if (vLeftReferences.empty() || vRightReferences.empty())
+			{
+				if (nodeReferenceAmount <= MAX_LEAF_PRIMITIVE_AMOUNT)
+				{
+					makeLeaf();
+					continue;
+				}
+
+				const Vector3 centroidExtent{ centroidBounds.largest - centroidBounds.smallest };
+				const int axis{ centroidExtent.x > centroidExtent.y ? (centroidExtent.x > centroidExtent.z ? 0 : 2) : (centroidExtent.y > centroidExtent.z ? 1 : 2) };
+
+				vLeftReferences = vReferences;
+				std::nth_element(vLeftReferences.begin(), vLeftReferences.begin() + nodeReferenceAmount / 2, vLeftReferences.end(),
+					[axis](const Reference& leftReference, const Reference& rightReference) { return leftReference.bounds.GetCentroid()[axis] < rightReference.bounds.GetCentroid()[axis]; });
+
+				vRightReferences.assign(vLeftReferences.begin() + nodeReferenceAmount / 2, vLeftReferences.end());
+				vLeftReferences.resize(nodeReferenceAmount / 2);
+			}
+
+			AABB
+				leftBounds{},
+				rightBounds{};
+			for (const Reference& reference : vLeftReferences)
+				leftBounds.Grow(reference.bounds);
+
+			for (const Reference& reference : vRightReferences)
+				rightBounds.Grow(reference.bounds);
+
+			const int leftChildIndex{ static_cast<int>(m_vNodes.size()) };
+			m_vNodes.push_back(BVHNode(leftBounds, 0, 0));
+			m_vNodes.push_back(BVHNode(rightBounds, 0, 0));
+			m_vNodes[task.nodeIndex].leftFirst = leftChildIndex;
+
+			vTasks.push_back(Task(leftChildIndex, task.depth + 1, std::move(vLeftReferences)));
+			vTasks.push_back(Task(leftChildIndex + 1, task.depth + 1, std::move(vRightReferences)));
+		}
+	}
+
+	//	Recalculates the node bounds bottom-up while keeping the hierarchy, vPrimitiveBounds has to describe the same primitives as the last build
+	inline void Refit(const std::vector<AABB>& vPrimitiveBounds)
+	{
+		for (int nodeIndex{ static_cast<int>(m_vNodes.size()) - 1 }; nodeIndex >= 0; --nodeIndex)
+		{
+			BVHNode& node{ m_vNodes[nodeIndex] };
+			if (node.IsLeaf())
+				UpdateNodeBounds(node, vPrimitiveBounds);
+			else
+			{
+				node.bounds = m_vNodes[node.leftFirst].bounds;
+				node.bounds.Grow(m_vNodes[node.leftFirst + 1].bounds);
+			}
+		}
+	}
+
+	//	Collapses the binary nodes into wide nodes by repeatedly opening the internal child with the largest surface area,
+	//	the leaves keep referencing the same primitive indices; has to be called again after building or refitting
+	inline void Collapse()
+	{
+		m_vWideNodes.clear();
+		if (m_vNodes.empty())
+			return;
+
+		struct Task
+		{
+			int
+				nodeIndex,
+				wideNodeIndex;
+		};
+
+		m_vWideNodes.reserve(m_vNodes.size() / 2 + 1);
+		m_vWideNodes.push_back(WideBVHNode());
+		std::vector<Task> vTasks{ Task(0, 0) };
+		while (!vTasks.empty())
+		{
+			const Task task{ vTasks.back() };
+			vTasks.pop_back();
+
+			int
+				aChildIndices[WIDTH]{ task.nodeIndex },
+				childAmount{ 1 };
+
+			if (!m_vNodes[task.nodeIndex].IsLeaf())
+			{
+				aChildIndices[0] = m_vNodes[task.nodeIndex].leftFirst;
+				aChildIndices[1] = m_vNodes[task.nodeIndex].leftFirst + 1;
+				childAmount = 2;
+			}
+
+			while (childAmount < WIDTH)
+			{
+				int largestChild{ -1 };
+				float largestSurfaceArea{ -1.0f };
+				for (int child{}; child < childAmount; ++child)
+				{
+					const BVHNode& childNode{ m_vNodes[aChildIndices[child]] };
+					if (!childNode.IsLeaf() && childNode.bounds.GetSurfaceArea() > largestSurfaceArea)
+					{
+						largestChild = child;
+						largestSurfaceArea = childNode.bounds.GetSurfaceArea();
+					}
+				}
+
+				if (largestChild == -1)
+					break;
+
+				const int leftChildIndex{ m_vNodes[aChildIndices[largestChild]].leftFirst };
+				aChildIndices[largestChild] = leftChildIndex;
+				aChildIndices[childAmount++] = leftChildIndex + 1;
+			}
+
+			WideBVHNode wideNode{};
+			for (int child{}; child < WIDTH; ++child)
+			{
+				if (child >= childAmount)
+				{
+					wideNode.aPrimitiveAmounts[child] = -1;
+					continue;
+				}
+
+				const BVHNode& childNode{ m_vNodes[aChildIndices[child]] };
+				wideNode.aSmallestX[child] = childNode.bounds.smallest.x;
+				wideNode.aSmallestY[child] = childNode.bounds.smallest.y;
+				wideNode.aSmallestZ[child] = childNode.bounds.smallest.z;
+				wideNode.aLargestX[child] = childNode.bounds.largest.x;
+				wideNode.aLargestY[child] = childNode.bounds.largest.y;
+				wideNode.aLargestZ[child] = childNode.bounds.largest.z;
+
+				if (childNode.IsLeaf())
+				{
+					wideNode.aChildIndices[child] = childNode.leftFirst;
+					wideNode.aPrimitiveAmounts[child] = childNode.primitiveAmount;
+				}
+				else
+				{
+					wideNode.aChildIndices[child] = static_cast<int>(m_vWideNodes.size());
+					m_vWideNodes.push_back(WideBVHNode());
+					vTasks.push_back(Task(aChildIndices[child], wideNode.aChildIndices[child]));
+				}
+			}
+
+			m_vWideNodes[task.wideNodeIndex] = wideNode;
+		}
+	}
+
+	//	Quantizes the wide nodes, which have to be collapsed first; the node indices are kept so both layouts describe the same hierarchy.
+	//	Leaves forced at MAX_DEPTH can hold more primitives than the packed children fit, in that case no quantized nodes get built
+	inline bool Quantize()
+	{
+		static constexpr float QUANTIZATION_STEPS{ 255.0f };
+
+		m_vQuantizedNodes.clear();
+		for (const WideBVHNode& wideNode : m_vWideNodes)
+			for (int child{}; child < WIDTH; ++child)
+				if (wideNode.aPrimitiveAmounts[child] > 0 &&
+					(static_cast<unsigned int>(wideNode.aPrimitiveAmounts[child]) > QuantizedWideBVHNode::MAX_PRIMITIVE_AMOUNT ||
+					static_cast<unsigned int>(wideNode.aChildIndices[child]) > QuantizedWideBVHNode::FIRST_PRIMITIVE_MASK))
+					return false;
+
+		m_vQuantizedNodes.resize(m_vWideNodes.size());
+		for (int nodeIndex{}; nodeIndex < m_vWideNodes.size(); ++nodeIndex)
+		{
+			const WideBVHNode& wideNode{ m_vWideNodes[nodeIndex] };
+			QuantizedWideBVHNode& quantizedNode{ m_vQuantizedNodes[nodeIndex] };
+			quantizedNode = QuantizedWideBVHNode();
+
+			const float* const apSmallest[3]{ wideNode.aSmallestX, wideNode.aSmallestY, wideNode.aSmallestZ };
+			const float* const apLargest[3]{ wideNode.aLargestX, wideNode.aLargestY, wideNode.aLargestZ };
+			unsigned char* const apQuantizedSmallest[3]{ quantizedNode.aSmallestX, quantizedNode.aSmallestY, quantizedNode.aSmallestZ };
+			unsigned char* const apQuantizedLargest[3]{ quantizedNode.aLargestX, quantizedNode.aLargestY, quantizedNode.aLargestZ };
+
+			for (int axis{}; axis < 3; ++axis)
+			{
+				float
+					origin{ FLT_MAX },
+					largest{ -FLT_MAX };
+				for (int child{}; child < WIDTH; ++child)
+					if (wideNode.aPrimitiveAmounts[child] != -1)
+					{
+						origin = std::min(origin, apSmallest[axis][child]);
+						largest = std::max(largest, apLargest[axis][child]);
+					}
+
+				//	The grid has to reach strictly past the node, so a rounding difference when dequantizing can't cut off a child
+				int scaleExponent{ -127 };
+				if (largest > origin)
+				{
+					scaleExponent = std::max(-126, static_cast<int>(std::ceil(std::log2((largest - origin) / QUANTIZATION_STEPS))));
+					while (scaleExponent < 127 && origin + QUANTIZATION_STEPS * QuantizedWideBVHNode::GetScale(static_cast<signed char>(scaleExponent)) <= largest)
+						++scaleExponent;
+				}
+
+				const float scale{ QuantizedWideBVHNode::GetScale(static_cast<signed char>(scaleExponent)) };
+				quantizedNode.aOrigin[axis] = origin;
+				quantizedNode.aScaleExponents[axis] = static_cast<signed char>(scaleExponent);
+
+				for (int child{}; child < WIDTH; ++child)
+				{
+					if (wideNode.aPrimitiveAmounts[child] == -1)
+						continue;
+
+					int
+						smallest{},
+						largestStep{};
+					if (scale > 0.0f)
+					{
+						smallest = std::clamp(static_cast<int>(std::floor((apSmallest[axis][child] - origin) / scale)), 0, 255);
+						while (smallest > 0 && origin + smallest * scale >= apSmallest[axis][child])
+							--smallest;
+
+						largestStep = std::clamp(static_cast<int>(std::ceil((apLargest[axis][child] - origin) / scale)), 0, 255);
+						while (largestStep < 255 && origin + largestStep * scale <= apLargest[axis][child])
+							++largestStep;
+					}
+
+					apQuantizedSmallest[axis][child] = static_cast<unsigned char>(smallest);
+					apQuantizedLargest[axis][child] = static_cast<unsigned char>(largestStep);
+				}
+			}
+
+			for (int child{}; child < WIDTH; ++child)
+			{
+				const int primitiveAmount{ wideNode.aPrimitiveAmounts[child] };
+				if (primitiveAmount == -1)
+					continue;
+
+				quantizedNode.usedChildMask |= 1 << child;
+				quantizedNode.aChildren[child] = primitiveAmount
+					? QuantizedWideBVHNode::LEAF_FLAG | static_cast<unsigned int>(primitiveAmount - 1) << QuantizedWideBVHNode::PRIMITIVE_AMOUNT_SHIFT | static_cast<unsigned int>(wideNode.aChildIndices[child])
+					: static_cast<unsigned int>(wideNode.aChildIndices[child]);
+			}
+		}
+
+		return true;
+	}
+
+	//	Derives the nodes of the layout traversal uses from the binary nodes, which are kept for refitting and packet traversal.
+	//	Only one of the wide layouts is kept, quantized falls back to the full precision nodes when Quantize fails.
+	//	The layout is remembered, so rebuilding after a refit keeps it
+	inline void BuildLayout(BVHLayout layout)
+	{
+		m_Layout = layout;
+		m_vWideNodes.clear();
+		m_vQuantizedNodes.clear();
+
+		if (layout != BVHLayout::binary)
+			Collapse();
+
+		if (layout == BVHLayout::quantized && Quantize())
+			m_vWideNodes.clear();
+
+		m_vWideNodes.shrink_to_fit();
+		m_vQuantizedNodes.shrink_to_fit();
+	}
+
+	//	Relative to the root surface area, this sum approximates the SAH cost of the hierarchy
+	inline float GetSurfaceAreaSum() const
+	{
+		float surfaceAreaSum{};
+		for (const BVHNode& node : m_vNodes)
+			surfaceAreaSum += node.bounds.GetSurfaceArea();
+
+		return surfaceAreaSum;
+	}
+
+	inline BVHLayout GetLayout() const
+	{
+		return m_Layout;
+	}
+
+	inline const std::vector<BVHNode>& GetNodes() const
+	{
+		return m_vNodes;
+	}
+
+	inline const std::vector<WideBVHNode>& GetWideNodes() const
+	{
+		return m_vWideNodes;
+	}
+
+	inline const std::vector<QuantizedWideBVHNode>& GetQuantizedNodes() const
+	{
+		return m_vQuantizedNodes;
+	}
+
+	inline const std::vector<int>& GetPrimitiveIndices() const
+	{
+		return m_vPrimitiveIndices;
+	}
+
+	inline int GetPrimitiveAmount() const
+	{
+		return static_cast<int>(m_vPrimitiveIndices.size());
+	}
+
+private:
+	static constexpr int
+		//	Nodes with at most this many primitives get their subtree built on a single thread
+		PARALLEL_SUBTREE_PRIMITIVE_AMOUNT{ 8192 },
+		//	Nodes with more primitives get binned in parallel chunks of this size
+		PARALLEL_BINNING_CHUNK_SIZE{ 16384 };
+
+	//	Resets the hierarchy to a root referencing every primitive, returns false when there are none
+	inline bool InitializeBuild(const std::vector<AABB>& vPrimitiveBounds)
+	{
+		m_vNodes.clear();
+		m_vPrimitiveIndices.resize(vPrimitiveBounds.size());
+		std::iota(m_vPrimitiveIndices.begin(), m_vPrimitiveIndices.end(), 0);
+
+		if (vPrimitiveBounds.empty())
+			return false;
+
+		m_vNodes.reserve(2 * vPrimitiveBounds.size());
+		m_vNodes.push_back(BVHNode(AABB(), 0, static_cast<int>(vPrimitiveBounds.size())));
+		UpdateNodeBounds(m_vNodes[0], vPrimitiveBounds);
+		return true;
+	}
+
+	//	Splits nodes top-down with splitNode(vNodes, nodeIndex), which appends both children to vNodes or returns false for leaves.
+	//	The large nodes near the root get split in place, their small descendants become subtrees that get built into separate
+	//	node vectors in parallel and get appended afterwards
+	template<typename SplitNodeFunction>
+	inline void BuildHierarchy(SplitNodeFunction splitNode)
+	{
+		struct Task
+		{
+			int
+				nodeIndex,
+				depth;
+		};
+
+		struct Subtree
+		{
+			Task task;
+			std::vector<BVHNode> vNodes;
+		};
+
+		const auto buildSubtree
+		{
+			[&splitNode](std::vector<BVHNode>& vNodes, const Task& rootTask)
+			{
+				std::vector<Task> vTasks{ rootTask };
+				while (!vTasks.empty())
+				{
+					const Task task{ vTasks.back() };
+					vTasks.pop_back();
+
+					if (task.depth >= MAX_DEPTH - 1 || !splitNode(vNodes, task.nodeIndex))
+						continue;
+
+					vTasks.push_back(Task(vNodes[task.nodeIndex].leftFirst, task.depth + 1));
+					vTasks.push_back(Task(vNodes[task.nodeIndex].leftFirst + 1, task.depth + 1));
+				}
+			}
+		};
+
+		std::vector<Subtree> vSubtrees{};
+		std::vector<Task> vTasks{ Task(0, 0) };
+		while (!vTasks.empty())
+		{
+			const Task task{ vTasks.back() };
+			vTasks.pop_back();
+
+			if (m_vNodes[task.nodeIndex].primitiveAmount <= PARALLEL_SUBTREE_PRIMITIVE_AMOUNT)
+			{
+				vSubtrees.push_back(Subtree(task, { m_vNodes[task.nodeIndex] }));
+				continue;
+			}
+
+			if (task.depth >= MAX_DEPTH - 1 || !splitNode(m_vNodes, task.nodeIndex))
+				continue;
+
+			vTasks.push_back(Task(m_vNodes[task.nodeIndex].leftFirst, task.depth + 1));
+			vTasks.push_back(Task(m_vNodes[task.nodeIndex].leftFirst + 1, task.depth + 1));
+		}
+
+		std::for_each(std::execution::par, vSubtrees.begin(), vSubtrees.end(),
+			[&buildSubtree](Subtree& subtree)
+			{
+				subtree.vNodes.reserve(2 * subtree.vNodes[0].primitiveAmount);
+				buildSubtree(subtree.vNodes, Task(0, subtree.task.depth));
+			});
+
+		//	The subtree root replaces its node, the other nodes keep their order so siblings stay next to each other
+		for (Subtree& subtree : vSubtrees)
+		{
+			const int indexOffset{ static_cast<int>(m_vNodes.size()) - 1 };
+			for (BVHNode& node : subtree.vNodes)
+				if (!node.IsLeaf())
+					node.leftFirst += indexOffset;
+
+			m_vNodes[subtree.task.nodeIndex] = subtree.vNodes[0];
+			m_vNodes.insert(m_vNodes.end(), subtree.vNodes.begin() + 1, subtree.vNodes.end());
+		}
+	}
+
+	inline bool SplitNodeBinnedSAH(std::vector<BVHNode>& vNodes, int nodeIndex, const std::vector<AABB>& vPrimitiveBounds, const std::vector<Vector3>& vCentroids)
+	{
+		const BVHNode node{ vNodes[nodeIndex] };
+		if (node.primitiveAmount <= 1)
+			return false;
+
+		struct Bin
+		{
+			AABB bounds;
+			int primitiveAmount;
+		};
+
+		//	Every chunk bins its own range of primitives, small nodes are a single chunk
+		struct Chunk
+		{
+			int
+				first,
+				amount;
+
+			AABB centroidBounds;
+			Bin aBins[3][BIN_AMOUNT];
+		};
+
+		Chunk nodeChunk{ node.leftFirst, node.primitiveAmount };
+		std::vector<Chunk> vParallelChunks{};
+		if (node.primitiveAmount > PARALLEL_BINNING_CHUNK_SIZE)
+			for (int first{ node.leftFirst }; first < node.leftFirst + node.primitiveAmount; first += PARALLEL_BINNING_CHUNK_SIZE)
+				vParallelChunks.push_back(Chunk(first, std::min(PARALLEL_BINNING_CHUNK_SIZE, node.leftFirst + node.primitiveAmount - first)));
+
+		const bool isParallel{ !vParallelChunks.empty() };
+		const std::span<Chunk> vChunks{ isParallel ? std::span<Chunk>(vParallelChunks) : std::span<Chunk>(&nodeChunk, 1) };
+
+		const auto forEachChunk
+		{
+			[&vChunks, isParallel](const auto& function)
+			{
+				if (isParallel)
+					std::for_each(std::execution::par, vChunks.begin(), vChunks.end(), function);
+				else
+					function(vChunks[0]);
+			}
+		};
+
+		forEachChunk(
+			[this, &vCentroids](Chunk& chunk)
+			{
+				for (int index{ chunk.first }; index < chunk.first + chunk.amount; ++index)
+					chunk.centroidBounds.Grow(vCentroids[m_vPrimitiveIndices[index]]);
+			});
+
+		AABB centroidBounds{};
+		for (const Chunk& chunk : vChunks)
+			centroidBounds.Grow(chunk.centroidBounds);
+
+		const Vector3 centroidExtent{ centroidBounds.largest - centroidBounds.smallest };
+		const Vector3 binScale
+		{
+			centroidExtent.x > 0.0f ? BIN_AMOUNT / centroidExtent.x : 0.0f,
+			centroidExtent.y > 0.0f ? BIN_AMOUNT / centroidExtent.y : 0.0f,
+			centroidExtent.z > 0.0f ? BIN_AMOUNT / centroidExtent.z : 0.0f
+		};
+
+		forEachChunk(
+			[this, &vPrimitiveBounds, &vCentroids, &centroidBounds, &binScale](Chunk& chunk)
+			{
+				const int
+					first{ chunk.first },
+					last{ chunk.first + chunk.amount };
+
+				for (int axis{}; axis < 3; ++axis)
+				{
+					const float
+						smallestCentroid{ centroidBounds.smallest[axis] },
+						axisBinScale{ binScale[axis] };
+
+					if (axisBinScale == 0.0f)
+						continue;
+
+					for (int index{ first }; index < last; ++index)
+					{
+						const int primitiveIndex{ m_vPrimitiveIndices[index] };
+						Bin& bin{ chunk.aBins[axis][std::min(BIN_AMOUNT - 1, static_cast<int>((vCentroids[primitiveIndex][axis] - smallestCentroid) * axisBinScale))] };
+						bin.bounds.Grow(vPrimitiveBounds[primitiveIndex]);
+						++bin.primitiveAmount;
+					}
+				}
+			});
+
+		int
+			bestAxis{ -1 },
+			bestSplit{};
+		float bestCost{ node.primitiveAmount * node.bounds.GetSurfaceArea() };
+		AABB
+			bestLeftBounds{},
+			bestRightBounds{};
+
+		//	The bins of every chunk get merged into the first one
+		for (int chunkIndex{ 1 }; chunkIndex < vChunks.size(); ++chunkIndex)
+			for (int axis{}; axis < 3; ++axis)
+				for (int index{}; index < BIN_AMOUNT; ++index)
+				{
+					vChunks[0].aBins[axis][index].bounds.Grow(vChunks[chunkIndex].aBins[axis][index].bounds);
+					vChunks[0].aBins[axis][index].primitiveAmount += vChunks[chunkIndex].aBins[axis][index].primitiveAmount;
+				}
+
+		for (int axis{}; axis < 3; ++axis)
+		{
+			if (binScale[axis] == 0.0f)
+				continue;
+
+			const Bin(&aBins)[BIN_AMOUNT]{ vChunks[0].aBins[axis] };
+
+			AABB aLeftBounds[BIN_AMOUNT - 1];
+			int aLeftAmounts[BIN_AMOUNT - 1];
+			AABB leftBounds{};
+			int leftAmount{};
+			for (int index{}; index < BIN_AMOUNT - 1; ++index)
+			{
+				leftBounds.Grow(aBins[index].bounds);
+				leftAmount += aBins[index].primitiveAmount;
+				aLeftBounds[index] = leftBounds;
+				aLeftAmounts[index] = leftAmount;
+			}
+
+			AABB rightBounds{};
+			int rightAmount{};
+			for (int index{ BIN_AMOUNT - 1 }; index > 0; --index)
+			{
+				rightBounds.Grow(aBins[index].bounds);
+				rightAmount += aBins[index].primitiveAmount;
+
+				if (!aLeftAmounts[index - 1] || !rightAmount)
+					continue;
+
+				const float cost{ aLeftAmounts[index - 1] * aLeftBounds[index - 1].GetSurfaceArea() + rightAmount * rightBounds.GetSurfaceArea() };
+				if (cost < bestCost)
+				{
+					bestCost = cost;
+					bestAxis = axis;
+					bestSplit = index;
+					bestLeftBounds = aLeftBounds[index - 1];
+					bestRightBounds = rightBounds;
+				}
+			}
+		}
+
+		const auto first{ m_vPrimitiveIndices.begin() + node.leftFirst };
+		const auto last{ first + node.primitiveAmount };
+
+		int leftAmount{};
+		if (bestAxis != -1)
+		{
+			const auto isLeft
+			{
+				[&vCentroids, smallestCentroid = centroidBounds.smallest[bestAxis], axisBinScale = binScale[bestAxis], bestAxis, bestSplit](int primitiveIndex)
+				{
+					return std::min(BIN_AMOUNT - 1, static_cast<int>((vCentroids[primitiveIndex][bestAxis] - smallestCentroid) * axisBinScale)) < bestSplit;
+				}
+			};
+
+			leftAmount = static_cast<int>((isParallel ? std::partition(std::execution::par, first, last, isLeft) : std::partition(first, last, isLeft)) - first);
+		}
+		else
+		{
+			if (node.primitiveAmount <= MAX_LEAF_PRIMITIVE_AMOUNT)
+				return false;
+
+			//	Leaves have to stay small enough to be packed in a quantized node, fall back to a median split along the widest centroid axis
+			const int axis{ centroidExtent.x > centroidExtent.y ? (centroidExtent.x > centroidExtent.z ? 0 : 2) : (centroidExtent.y > centroidExtent.z ? 1 : 2) };
+
+			leftAmount = node.primitiveAmount / 2;
+			std::nth_element(first, first + leftAmount, last,
+				[&vCentroids, axis](int leftPrimitive, int rightPrimitive) { return vCentroids[leftPrimitive][axis] < vCentroids[rightPrimitive][axis]; });
+		}
+
+		const int leftChildIndex{ static_cast<int>(vNodes.size()) };
+		vNodes.push_back(BVHNode(bestLeftBounds, node.leftFirst, leftAmount));
+		vNodes.push_back(BVHNode(bestRightBounds, node.leftFirst + leftAmount, node.primitiveAmount - leftAmount));
+		if (bestAxis == -1)
+		{
+			UpdateNodeBounds(vNodes[leftChildIndex], vPrimitiveBounds);
+			UpdateNodeBounds(vNodes[leftChildIndex + 1], vPrimitiveBounds);
+		}
+
+		vNodes[nodeIndex].leftFirst = leftChildIndex;
+		vNodes[nodeIndex].primitiveAmount = 0;
+		return true;
+	}
+
+	//	Sorts the primitive indices by their Morton codes with a least significant digit radix sort, every pass counts and scatters
+	//	the digits of parallel chunks; the codes end up sorted along with them
+	inline void SortByMortonCode(std::vector<unsigned int>& vMortonCodes)
+	{
+		static constexpr int
+			DIGIT_BITS{ 8 },
+			DIGIT_AMOUNT{ 1 << DIGIT_BITS },
+			//	Morton codes use the lowest 30 bits
+			PASS_AMOUNT{ (30 + DIGIT_BITS - 1) / DIGIT_BITS };
+
+		struct Chunk
+		{
+			int
+				first,
+				amount;
+
+			int aDigitOffsets[DIGIT_AMOUNT];
+		};
+
+		const int primitiveAmount{ static_cast<int>(vMortonCodes.size()) };
+		std::vector<Chunk> vChunks{};
+		for (int first{}; first < primitiveAmount; first += PARALLEL_BINNING_CHUNK_SIZE)
+			vChunks.push_back(Chunk(first, std::min(PARALLEL_BINNING_CHUNK_SIZE, primitiveAmount - first)));
+
+		std::vector<unsigned int> vSortedMortonCodes(vMortonCodes.size());
+		std::vector<int> vSortedPrimitiveIndices(m_vPrimitiveIndices.size());
+		for (int pass{}; pass < PASS_AMOUNT; ++pass)
+		{
+			const int shift{ pass * DIGIT_BITS };
+
+			std::for_each(std::execution::par, vChunks.begin(), vChunks.end(),
+				[&vMortonCodes, shift](Chunk& chunk)
+				{
+					std::fill(std::begin(chunk.aDigitOffsets), std::end(chunk.aDigitOffsets), 0);
+					for (int index{ chunk.first }; index < chunk.first + chunk.amount; ++index)
+						++chunk.aDigitOffsets[(vMortonCodes[index] >> shift) & (DIGIT_AMOUNT - 1)];
+				});
+
+			//	Turns the counts into the output positions, ordered by digit first and chunk second to keep the sort stable
+			int offset{};
+			for (int digit{}; digit < DIGIT_AMOUNT; ++digit)
+				for (Chunk& chunk : vChunks)
+				{
+					const int digitAmount{ chunk.aDigitOffsets[digit] };
+					chunk.aDigitOffsets[digit] = offset;
+					offset += digitAmount;
+				}
+
+			std::for_each(std::execution::par, vChunks.begin(), vChunks.end(),
+				[this, &vMortonCodes, &vSortedMortonCodes, &vSortedPrimitiveIndices, shift](Chunk& chunk)
+				{
+					for (int index{ chunk.first }; index < chunk.first + chunk.amount; ++index)
+					{
+						const int sortedIndex{ chunk.aDigitOffsets[(vMortonCodes[index] >> shift) & (DIGIT_AMOUNT - 1)]++ };
+						vSortedMortonCodes[sortedIndex] = vMortonCodes[index];
+						vSortedPrimitiveIndices[sortedIndex] = m_vPrimitiveIndices[index];
+					}
+				});
+
+			vMortonCodes.swap(vSortedMortonCodes);
+			m_vPrimitiveIndices.swap(vSortedPrimitiveIndices);
+		}
+	}
+
+	inline void UpdateNodeBounds(BVHNode& node, const std::vector<AABB>& vPrimitiveBounds) const
+	{
+		node.bounds = AABB();
+		for (int index{ node.leftFirst }; index < node.leftFirst + node.primitiveAmount; ++index)
+			node.bounds.Grow(vPrimitiveBounds[m_vPrimitiveIndices[index]]);
+	}
+
+	std::vector<BVHNode> m_vNodes;
+	std::vector<WideBVHNode> m_vWideNodes;
+	std::vector<QuantizedWideBVHNode> m_vQuantizedNodes;
+	std::vector<int> m_vPrimitiveIndices;
+	BVHLayout m_Layout{ DEFAULT_BVH_LAYOUT };
+};
\ No newline at end of file
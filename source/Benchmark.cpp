@@ -0,0 +1,918 @@
+#include "Benchmark.h"
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <thread>
+
+#include "SDL.h"
+#include "Scene.h"
+#include "Utilities.hpp"
+#include "ColorRGBx8.hpp"
+
+static constexpr int
+BENCHMARK_RAY_RESOLUTION{ 256 },
+BENCHMARK_REPETITIONS{ 4 };
+
+//	Rays from the origin towards a grid spanning the given bounds, so most of them have to traverse the structure
+static std::vector<Ray> GenerateBenchmarkRays(const Vector3& origin, const AABB& target)
+{
+	std::vector<Ray> vRays;
+	vRays.reserve(BENCHMARK_RAY_RESOLUTION * BENCHMARK_RAY_RESOLUTION);
+
+	const Vector3 centroid{ target.GetCentroid() };
+	for (int y{}; y < BENCHMARK_RAY_RESOLUTION; ++y)
+		for (int x{}; x < BENCHMARK_RAY_RESOLUTION; ++x)
+		{
+			const Vector3 targetPoint
+			{
+				Lerp(target.smallest.x, target.largest.x, (x + 0.5f) / BENCHMARK_RAY_RESOLUTION),
+				Lerp(target.smallest.y, target.largest.y, (y + 0.5f) / BENCHMARK_RAY_RESOLUTION),
+				centroid.z
+			};
+
+			vRays.push_back(Ray(origin, (targetPoint - origin).GetNormalized()));
+		}
+
+	return vRays;
+}
+
+static std::vector<Ray> GenerateCameraRays(const Camera& camera)
+{
+	std::vector<Ray> vRays;
+	vRays.reserve(BENCHMARK_RAY_RESOLUTION * BENCHMARK_RAY_RESOLUTION);
+
+	const float fieldOfViewValue{ camera.GetFieldOfViewValue() };
+	for (int y{}; y < BENCHMARK_RAY_RESOLUTION; ++y)
+		for (int x{}; x < BENCHMARK_RAY_RESOLUTION; ++x)
+		{
+			const Vector3 rayDirection
+			{
+				(2.0f * (x + 0.5f) / BENCHMARK_RAY_RESOLUTION - 1.0f) * fieldOfViewValue,
+				(1.0f - 2.0f * (y + 0.5f) / BENCHMARK_RAY_RESOLUTION) * fieldOfViewValue,
+				1.0f
+			};
+
+			vRays.push_back(Ray(camera.GetOrigin(), camera.GetCameraToWorld().TransformVector(rayDirection.GetNormalized())));
+		}
+
+	return vRays;
+}
+
+//	Shadow rays from the closest hits of the given rays towards the light, rays that hit nothing leave an empty ray with min above max
+static std::vector<Ray> GenerateShadowRays(const Scene& scene, const std::vector<Ray>& vRays, const Light& light)
+{
+	std::vector<Ray> vShadowRays;
+	vShadowRays.reserve(vRays.size());
+
+	for (const Ray& ray : vRays)
+	{
+		HitRecord closestHit;
+		scene.GetClosestHit(ray, closestHit);
+		vShadowRays.push_back(closestHit.didHit ? GetLightRay(light, scene.GetSurfacePoint(ray, closestHit).origin) : Ray(Vector3(), Vector3(), 1.0f, 0.0f));
+	}
+
+	return vShadowRays;
+}
+
+//	Groups the rays of a BENCHMARK_RAY_RESOLUTION grid into packets of neighbouring rays, like the renderer does with pixels
+static std::vector<RayPacket> GetRayPackets(const std::vector<Ray>& vRays)
+{
+	std::vector<RayPacket> vPackets;
+	for (int packetY{}; packetY < BENCHMARK_RAY_RESOLUTION; packetY += RayPacket::HEIGHT)
+		for (int packetX{}; packetX < BENCHMARK_RAY_RESOLUTION; packetX += RayPacket::WIDTH)
+		{
+			RayPacket packet{};
+			for (int lane{}; lane < RayPacket::SIZE; ++lane)
+			{
+				const Ray& ray{ vRays[(packetY + lane / RayPacket::WIDTH) * BENCHMARK_RAY_RESOLUTION + packetX + lane % RayPacket::WIDTH] };
+				if (ray.min <= ray.max)
+					packet.SetRay(lane, ray);
+			}
+
+			vPackets.push_back(packet);
+		}
+
+	return vPackets;
+}
+
+//	Returns the throughput in million rays per second
+template<typename HitTestFunction>
+static float MeasureThroughput(const std::vector<Ray>& vRays, HitTestFunction hitTest, int& hitAmount)
+{
+	hitAmount = 0;
+
+	const uint64_t startTime{ SDL_GetPerformanceCounter() };
+	for (int repetition{}; repetition < BENCHMARK_REPETITIONS; ++repetition)
+		for (const Ray& ray : vRays)
+		{
+			HitRecord hitRecord;
+			if (hitTest(ray, hitRecord))
+				++hitAmount;
+		}
+
+	const float elapsedTime{ float(SDL_GetPerformanceCounter() - startTime) / SDL_GetPerformanceFrequency() };
+	hitAmount /= BENCHMARK_REPETITIONS;
+	return BENCHMARK_REPETITIONS * vRays.size() / elapsedTime / 1'000'000.0f;
+}
+
+//	Returns the throughput in million rays per second, hitTest(packet) returns the amount of lanes that hit
+template<typename HitTestFunction>
+static float MeasurePacketThroughput(const std::vector<RayPacket>& vPackets, HitTestFunction hitTest, int& hitAmount)
+{
+	hitAmount = 0;
+
+	int rayAmount{};
+	for (const RayPacket& packet : vPackets)
+		rayAmount += std::popcount(static_cast<unsigned int>(packet.activeMask));
+
+	const uint64_t startTime{ SDL_GetPerformanceCounter() };
+	for (int repetition{}; repetition < BENCHMARK_REPETITIONS; ++repetition)
+		for (const RayPacket& packet : vPackets)
+			hitAmount += hitTest(packet);
+
+	const float elapsedTime{ float(SDL_GetPerformanceCounter() - startTime) / SDL_GetPerformanceFrequency() };
+	hitAmount /= BENCHMARK_REPETITIONS;
+	return BENCHMARK_REPETITIONS * rayAmount / elapsedTime / 1'000'000.0f;
+}
+
+static void BenchmarkScene(const Scene& scene, std::ostream& report)
+{
+	const std::vector<Ray> vRays{ GenerateCameraRays(scene.GetCamera()) };
+
+	int
+		closestHitAmount,
+		anyHitAmount;
+
+	const float
+		closestHit{ MeasureThroughput(vRays, [&scene](const Ray& ray, HitRecord& hitRecord) { scene.GetClosestHit(ray, hitRecord); return hitRecord.didHit; }, closestHitAmount) },
+		anyHit{ MeasureThroughput(vRays, [&scene](const Ray& ray, HitRecord&) { return scene.DoesHit(ray); }, anyHitAmount) };
+
+	report
+		<< "SCENE (" << scene.GetSpheres().size() << " spheres, " << scene.GetPlanes().size() << " planes, " << scene.GetTriangleMeshes().size() << " triangle meshes)\n"
+		<< ">> CAMERA RAYS: CLOSEST HIT = " << closestHit << " MRays/s, ANY HIT = " << anyHit << " MRays/s\n";
+
+	if (scene.GetLights().empty())
+		return;
+
+	const std::vector<Ray> vShadowRays{ GenerateShadowRays(scene, vRays, scene.GetLights()[0]) };
+
+	std::vector<Ray> vNonEmptyShadowRays;
+	std::copy_if(vShadowRays.begin(), vShadowRays.end(), std::back_inserter(vNonEmptyShadowRays), [](const Ray& ray) { return ray.min <= ray.max; });
+
+	int
+		shadowHitAmount,
+		closestHitPacketAmount,
+		shadowPacketHitAmount;
+
+	const float
+		shadow{ MeasureThroughput(vNonEmptyShadowRays, [&scene](const Ray& ray, HitRecord&) { return scene.DoesHit(ray); }, shadowHitAmount) },
+		closestHitPacket
+		{
+			MeasurePacketThroughput(GetRayPackets(vRays),
+				[&scene](const RayPacket& packet)
+				{
+					HitRecord aClosestHits[RayPacket::SIZE];
+					scene.GetClosestHit(packet, aClosestHits);
+
+					int hitAmount{};
+					for (const HitRecord& closestHit : aClosestHits)
+						hitAmount += closestHit.didHit;
+
+					return hitAmount;
+				}, closestHitPacketAmount)
+		},
+		shadowPacket
+		{
+			MeasurePacketThroughput(GetRayPackets(vShadowRays),
+				[&scene](const RayPacket& packet)
+				{
+					return std::popcount(static_cast<unsigned int>(scene.DoesHit(packet)));
+				}, shadowPacketHitAmount)
+		};
+
+	report
+		<< ">> SHADOW RAYS: ANY HIT = " << shadow << " MRays/s\n"
+		<< ">> " << RayPacket::WIDTH << "x" << RayPacket::HEIGHT << " PACKETS: CLOSEST HIT = " << closestHitPacket << " MRays/s (x" << closestHitPacket / closestHit << " over single rays), "
+		<< "SHADOW = " << shadowPacket << " MRays/s (x" << shadowPacket / shadow << " over single rays)\n"
+		<< ">> HIT AMOUNTS " << (closestHitPacketAmount == closestHitAmount && shadowPacketHitAmount == shadowHitAmount ? "MATCH" : "DIFFER") << std::endl;
+}
+
+//	A displaced grid facing -z, large enough to not fit in the caches
+static std::shared_ptr<TriangleMeshGeometry> GenerateLargeGeometry(int resolution)
+{
+	std::vector<Vector3> vPositions;
+	vPositions.reserve(resolution * resolution);
+	for (int y{}; y < resolution; ++y)
+		for (int x{}; x < resolution; ++x)
+		{
+			const float
+				u{ 10.0f * x / (resolution - 1) - 5.0f },
+				v{ 10.0f * y / (resolution - 1) - 5.0f };
+
+			vPositions.push_back(Vector3(u, v, 0.5f * sinf(3.0f * u) * cosf(3.0f * v)));
+		}
+
+	std::vector<int> vIndices;
+	vIndices.reserve(6 * (resolution - 1) * (resolution - 1));
+	for (int y{}; y < resolution - 1; ++y)
+		for (int x{}; x < resolution - 1; ++x)
+		{
+			const int index{ y * resolution + x };
+			vIndices.insert(vIndices.end(), { index, index + resolution, index + 1 });
+			vIndices.insert(vIndices.end(), { index + 1, index + resolution, index + resolution + 1 });
+		}
+
+	return std::make_shared<TriangleMeshGeometry>(std::move(vPositions), std::move(vIndices));
+}
+
+//	Layers of long, thin diagonal quads whose bounds overlap their neighbours a lot, like the walls and beams in architectural scenes
+static std::shared_ptr<TriangleMeshGeometry> GenerateSliverGeometry(int cellAmount)
+{
+	static constexpr int
+		LAYER_AMOUNT{ 4 },
+		SLIVER_LENGTH{ 8 };
+
+	static constexpr float SLIVER_WIDTH{ 0.1f };
+
+	std::vector<Vector3> vPositions;
+	std::vector<int> vIndices;
+
+	const float cellSize{ 20.0f / cellAmount };
+	for (int layer{}; layer < LAYER_AMOUNT; ++layer)
+		for (int y{}; y < cellAmount; ++y)
+			for (int x{}; x < cellAmount; ++x)
+			{
+				const Vector3
+					start{ cellSize * x - 10.0f, cellSize * y - 10.0f, float(layer) },
+					length{ SLIVER_LENGTH * cellSize, SLIVER_LENGTH * cellSize, 0.0f },
+					width{ SLIVER_WIDTH * cellSize, 0.0f, 0.0f };
+
+				const int index{ static_cast<int>(vPositions.size()) };
+				vPositions.insert(vPositions.end(), { start, start + width, start + length, start + length + width });
+				vIndices.insert(vIndices.end(), { index, index + 2, index + 1 });
+				vIndices.insert(vIndices.end(), { index + 1, index + 2, index + 3 });
+			}
+
+	return std::make_shared<TriangleMeshGeometry>(std::move(vPositions), std::move(vIndices));
+}
+
+static const char* GetBVHBuildQualityName(BVHBuildQuality bvhBuildQuality)
+{
+	switch (bvhBuildQuality)
+	{
+	case BVHBuildQuality::linear:
+		return "LBVH";
+
+	case BVHBuildQuality::fast:
+		return "BINNED SAH";
+
+	case BVHBuildQuality::spatialSplits:
+		return "SPATIAL SPLITS";
+	}
+
+	return "";
+}
+
+//	Rebuilds the geometry with every build quality, the last one is kept
+static void BenchmarkBuildQualities(const std::shared_ptr<TriangleMeshGeometry>& pGeometry, std::initializer_list<BVHBuildQuality> bvhBuildQualities, const Vector3& origin, std::ostream& report)
+{
+	const TriangleMesh triangleMesh{ pGeometry, 0, Triangle::CullMode::none };
+	const std::vector<Ray> vRays{ GenerateBenchmarkRays(origin, AABB(triangleMesh.smallestAABBTransformed, triangleMesh.largestAABBTransformed)) };
+	const float triangleMillions{ pGeometry->GetTriangleAmount() / 1'000'000.0f };
+
+	report << "BVH BUILDS (" << pGeometry->GetTriangleAmount() << " triangles, " << std::thread::hardware_concurrency() << " threads)\n";
+
+	int
+		firstClosestHitAmount{ -1 },
+		firstShadowHitAmount{ -1 };
+	bool doHitAmountsMatch{ true };
+	for (const BVHBuildQuality bvhBuildQuality : bvhBuildQualities)
+	{
+		pGeometry->bvhBuildQuality = bvhBuildQuality;
+
+		const uint64_t startTime{ SDL_GetPerformanceCounter() };
+		pGeometry->BuildBVH();
+		const float buildTime{ float(SDL_GetPerformanceCounter() - startTime) / SDL_GetPerformanceFrequency() };
+
+		int
+			closestHitAmount,
+			shadowHitAmount;
+
+		const float
+			closestHit{ MeasureThroughput(vRays, [&triangleMesh](const Ray& ray, HitRecord& hitRecord) { return HitTestTriangleMesh(triangleMesh, ray, hitRecord); }, closestHitAmount) },
+			shadow{ MeasureThroughput(vRays, [&triangleMesh](const Ray& ray, HitRecord&) { return HitTestTriangleMesh(triangleMesh, ray); }, shadowHitAmount) };
+
+		if (firstClosestHitAmount == -1)
+		{
+			firstClosestHitAmount = closestHitAmount;
+			firstShadowHitAmount = shadowHitAmount;
+		}
+
+		doHitAmountsMatch = doHitAmountsMatch && closestHitAmount == firstClosestHitAmount && shadowHitAmount == firstShadowHitAmount;
+
+		report
+			<< ">> " << GetBVHBuildQualityName(bvhBuildQuality) << ": " << buildTime * 1000.0f << " ms (" << buildTime * 1000.0f / triangleMillions << " ms per million triangles), "
+			<< float(pGeometry->bvh.GetPrimitiveIndices().size()) / pGeometry->GetTriangleAmount() << " references per triangle, "
+			<< "CLOSEST HIT = " << closestHit << " MRays/s, SHADOW = " << shadow << " MRays/s\n";
+	}
+
+	report << ">> HIT AMOUNTS " << (doHitAmountsMatch ? "MATCH" : "DIFFER") << std::endl;
+}
+
+//	Traversal only instantiates the default layout, so the others get built on a copy of the geometry that never gets rendered.
+//	The copy has no transform, it has to be traced with object space rays
+static TriangleMesh CreateLayoutMesh(const TriangleMesh& triangleMesh, BVHLayout layout)
+{
+	const std::shared_ptr<TriangleMeshGeometry> pGeometry{ std::make_shared<TriangleMeshGeometry>(triangleMesh.GetGeometry()) };
+	pGeometry->bvh.BuildLayout(layout);
+
+	return TriangleMesh(pGeometry, triangleMesh.materialIndex, triangleMesh.cullMode);
+}
+
+static void BenchmarkTriangleMesh(const TriangleMesh& triangleMesh, const Vector3& origin, bool includeLinear, std::ostream& report)
+{
+	static constexpr int LAYOUT_AMOUNT{ 3 };
+
+	const TriangleMeshGeometry& geometry{ triangleMesh.GetGeometry() };
+	const std::vector<Ray> vRays{ GenerateBenchmarkRays(origin, AABB(triangleMesh.smallestAABBTransformed, triangleMesh.largestAABBTransformed)) };
+
+	float
+		aLinear[2]{},
+		aaLayouts[2][LAYOUT_AMOUNT]{};
+
+	int
+		aLinearHitAmounts[2]{},
+		aaLayoutHitAmounts[2][LAYOUT_AMOUNT]{};
+
+	size_t
+		aNodeAmounts[LAYOUT_AMOUNT]{},
+		aNodeBytes[LAYOUT_AMOUNT]{};
+
+	if (includeLinear)
+		for (const bool isShadowRay : { false, true })
+			aLinear[isShadowRay] = MeasureThroughput(vRays,
+				[&triangleMesh, isShadowRay](const Ray& ray, HitRecord& hitRecord)
+				{
+					if (isShadowRay)
+						return HitTestTriangleMeshLinear(triangleMesh, ray);
+
+					return HitTestTriangleMeshLinear(triangleMesh, ray, hitRecord);
+				}, aLinearHitAmounts[isShadowRay]);
+
+	std::vector<Ray> vObjectSpaceRays{ vRays };
+	for (Ray& ray : vObjectSpaceRays)
+		ray = GetObjectSpaceRay(triangleMesh, ray);
+
+	bool isQuantized{ true };
+	const auto measureLayout
+	{
+		[&](auto layout)
+		{
+			constexpr BVHLayout LAYOUT{ decltype(layout)::value };
+			constexpr int LAYOUT_INDEX{ static_cast<int>(LAYOUT) };
+
+			const TriangleMesh layoutMesh{ CreateLayoutMesh(triangleMesh, LAYOUT) };
+			const BVH& bvh{ layoutMesh.GetGeometry().bvh };
+
+			//	Only one of the wide layouts is kept
+			aNodeAmounts[LAYOUT_INDEX] = LAYOUT == BVHLayout::binary ? bvh.GetNodes().size() : bvh.GetWideNodes().size() + bvh.GetQuantizedNodes().size();
+			aNodeBytes[LAYOUT_INDEX] = LAYOUT == BVHLayout::binary
+				? bvh.GetNodes().size() * sizeof(BVHNode)
+				: bvh.GetWideNodes().size() * sizeof(WideBVHNode) + bvh.GetQuantizedNodes().size() * sizeof(QuantizedWideBVHNode);
+
+			if (LAYOUT == BVHLayout::quantized)
+				isQuantized = !bvh.GetQuantizedNodes().empty();
+
+			for (const bool isShadowRay : { false, true })
+				aaLayouts[isShadowRay][LAYOUT_INDEX] = MeasureThroughput(vObjectSpaceRays,
+					[&layoutMesh, isShadowRay](const Ray& ray, HitRecord& hitRecord)
+					{
+						if (isShadowRay)
+							return HitTestTriangleMesh<LAYOUT>(layoutMesh, ray);
+
+						return HitTestTriangleMesh<LAYOUT>(layoutMesh, ray, hitRecord);
+					}, aaLayoutHitAmounts[isShadowRay][LAYOUT_INDEX]);
+		}
+	};
+
+	measureLayout(std::integral_constant<BVHLayout, BVHLayout::binary>());
+	measureLayout(std::integral_constant<BVHLayout, BVHLayout::wide>());
+	measureLayout(std::integral_constant<BVHLayout, BVHLayout::quantized>());
+
+	//	Every layout shares the primitive indices
+	const auto getBytesPerTriangle
+	{
+		[&geometry](size_t nodeBytes)
+		{
+			return float(nodeBytes + geometry.bvh.GetPrimitiveIndices().size() * sizeof(int)) / geometry.GetTriangleAmount();
+		}
+	};
+
+	static constexpr int
+		BINARY{ static_cast<int>(BVHLayout::binary) },
+		WIDE{ static_cast<int>(BVHLayout::wide) },
+		QUANTIZED{ static_cast<int>(BVHLayout::quantized) };
+
+	report
+		<< "TRIANGLE MESH (" << geometry.GetTriangleAmount() << " triangles, "
+		<< aNodeAmounts[BINARY] << " binary BVH nodes, "
+		<< aNodeAmounts[WIDE] << " wide BVH nodes)\n"
+		<< ">> BVH BYTES PER TRIANGLE: BINARY = " << getBytesPerTriangle(aNodeBytes[BINARY])
+		<< ", WIDE = " << getBytesPerTriangle(aNodeBytes[WIDE])
+		<< ", QUANTIZED = " << getBytesPerTriangle(aNodeBytes[QUANTIZED]) << (isQuantized ? "" : " (LEAVES TOO LARGE, KEPT THE WIDE NODES)") << "\n";
+
+	for (const bool isShadowRay : { false, true })
+	{
+		const float
+			linear{ aLinear[isShadowRay] },
+			binary{ aaLayouts[isShadowRay][BINARY] },
+			wide{ aaLayouts[isShadowRay][WIDE] },
+			quantized{ aaLayouts[isShadowRay][QUANTIZED] };
+
+		const int
+			linearHitAmount{ aLinearHitAmounts[isShadowRay] },
+			binaryHitAmount{ aaLayoutHitAmounts[isShadowRay][BINARY] },
+			wideHitAmount{ aaLayoutHitAmounts[isShadowRay][WIDE] },
+			quantizedHitAmount{ aaLayoutHitAmounts[isShadowRay][QUANTIZED] };
+
+		report << (isShadowRay ? ">> SHADOW: " : ">> CLOSEST HIT: ");
+		if (includeLinear)
+			report << "LINEAR = " << linear << " MRays/s, ";
+
+		report
+			<< "BINARY BVH = " << binary << " MRays/s, WIDE BVH = " << wide << " MRays/s (x" << wide / binary << " over binary), "
+			<< "QUANTIZED BVH = " << quantized << " MRays/s (x" << quantized / wide << " over wide)\n"
+			<< ">> HIT AMOUNTS " << ((includeLinear && linearHitAmount != binaryHitAmount) || binaryHitAmount != wideHitAmount || wideHitAmount != quantizedHitAmount ? "DIFFER" : "MATCH") << std::endl;
+	}
+}
+
+//	Leaf cost in isolation: every ray gets tested against every triangle, one at a time and four at a time
+static void BenchmarkTriangleIntersection(const TriangleMesh& triangleMesh, const Vector3& origin, std::ostream& report)
+{
+	const TriangleMeshGeometry& geometry{ triangleMesh.GetGeometry() };
+	const std::vector<int>& vPrimitiveIndices{ geometry.bvh.GetPrimitiveIndices() };
+	const int referenceAmount{ static_cast<int>(vPrimitiveIndices.size()) };
+
+	std::vector<Ray> vRays{ GenerateBenchmarkRays(origin, AABB(triangleMesh.smallestAABBTransformed, triangleMesh.largestAABBTransformed)) };
+	for (Ray& ray : vRays)
+		ray = GetObjectSpaceRay(triangleMesh, ray);
+
+	int scalarHitAmount{};
+	const uint64_t startTime{ SDL_GetPerformanceCounter() };
+	DispatchCullMode(triangleMesh.cullMode,
+		[&scalarHitAmount, &vRays, &geometry, &vPrimitiveIndices, referenceAmount](auto cullMode)
+		{
+			for (int repetition{}; repetition < BENCHMARK_REPETITIONS; ++repetition)
+				for (const Ray& ray : vRays)
+					for (int index{}; index < referenceAmount; ++index)
+					{
+						float t, u, v;
+						scalarHitAmount += GetTriangleHitDistance<decltype(cullMode)::value, false>(geometry.vPrecomputedTriangles[vPrimitiveIndices[index]], ray, t, u, v);
+					}
+		});
+
+	const float
+		scalarTime{ float(SDL_GetPerformanceCounter() - startTime) / SDL_GetPerformanceFrequency() },
+		testMillions{ float(BENCHMARK_REPETITIONS) * vRays.size() * referenceAmount / 1'000'000.0f };
+
+	report << ">> TRIANGLE TESTS: SCALAR = " << testMillions / scalarTime << " M/s";
+
+	//	Every register width the CPU supports, up to the one the renderer picked
+	bool doHitAmountsMatch{ true };
+	for (int instructionSet{}; instructionSet <= int(GetInstructionSet()); ++instructionSet)
+		DispatchInstructionSet(InstructionSet(instructionSet),
+			[&triangleMesh, &vRays, &geometry, referenceAmount, scalarHitAmount, scalarTime, testMillions, &doHitAmountsMatch, &report](auto instructionSet)
+			{
+				using Lanes = FloatLanes<decltype(instructionSet)::value>;
+
+				int wideHitAmount{};
+				const uint64_t startTime{ SDL_GetPerformanceCounter() };
+				DispatchCullMode(triangleMesh.cullMode,
+					[&wideHitAmount, &vRays, &geometry, referenceAmount](auto cullMode)
+					{
+						for (int repetition{}; repetition < BENCHMARK_REPETITIONS; ++repetition)
+							for (const Ray& ray : vRays)
+								for (int index{}; index < referenceAmount; index += Lanes::WIDTH)
+								{
+									typename Lanes::Type t, u, v;
+									const int laneMask{ (1 << std::min(referenceAmount - index, Lanes::WIDTH)) - 1 };
+									wideHitAmount += std::popcount(static_cast<unsigned int>(GetTriangleHitDistances<Lanes, decltype(cullMode)::value, false>(geometry.wideTriangles, index, laneMask, ray, t, u, v)));
+								}
+					});
+
+				const float wideTime{ float(SDL_GetPerformanceCounter() - startTime) / SDL_GetPerformanceFrequency() };
+				report << ", " << GetInstructionSetName(decltype(instructionSet)::value) << " x" << Lanes::WIDTH << " = " << testMillions / wideTime << " M/s (x" << scalarTime / wideTime << ")";
+
+				doHitAmountsMatch &= wideHitAmount == scalarHitAmount;
+			});
+
+	report
+		<< "\n"
+		<< ">> HIT AMOUNTS " << (doHitAmountsMatch ? "MATCH" : "DIFFER") << std::endl;
+}
+
+//	Random spheres and planes filling the bounds like the particles of a particle system, tested one by one and a register width at a time
+static void BenchmarkPrimitiveIntersection(int primitiveAmount, const Vector3& origin, const AABB& bounds, std::ostream& report)
+{
+	std::vector<Sphere> vSpheres;
+	std::vector<Plane> vPlanes;
+	for (int index{}; index < primitiveAmount; ++index)
+	{
+		const Vector3 position{ Lerp(bounds.smallest, bounds.largest, static_cast<float>(rand()) / RAND_MAX) + Vector3::GetRandom(-1.0f, 1.0f) };
+		vSpheres.push_back(Sphere(position, 0.05f + 0.1f * static_cast<float>(rand()) / RAND_MAX, 0));
+		vPlanes.push_back(Plane(position, Vector3::GetRandom(-1.0f, 1.0f).GetNormalized(), 0));
+	}
+
+	std::vector<int> vObjectIndices(primitiveAmount);
+	std::iota(vObjectIndices.begin(), vObjectIndices.end(), 0);
+
+	WideSpheres wideSpheres{};
+	wideSpheres.Build(vSpheres, vObjectIndices);
+
+	WidePlanes widePlanes{};
+	widePlanes.Build(vPlanes);
+
+	const std::vector<Ray> vRays{ GenerateBenchmarkRays(origin, bounds) };
+	const float testMillions{ float(BENCHMARK_REPETITIONS) * vRays.size() * primitiveAmount / 1'000'000.0f };
+
+	const auto measure
+	{
+		[&vRays](const auto& hitTestRay, int& hitAmount)
+		{
+			hitAmount = 0;
+
+			const uint64_t startTime{ SDL_GetPerformanceCounter() };
+			for (int repetition{}; repetition < BENCHMARK_REPETITIONS; ++repetition)
+				for (const Ray& ray : vRays)
+					hitAmount += hitTestRay(ray);
+
+			return float(SDL_GetPerformanceCounter() - startTime) / SDL_GetPerformanceFrequency();
+		}
+	};
+
+	//	Every register width the CPU supports, up to the one the renderer picked
+	const auto reportWide
+	{
+		[&measure, &report, primitiveAmount, testMillions](const auto& getHitDistances, float scalarTime, int scalarHitAmount)
+		{
+			bool doHitAmountsMatch{ true };
+			for (int instructionSet{}; instructionSet <= int(GetInstructionSet()); ++instructionSet)
+				DispatchInstructionSet(InstructionSet(instructionSet),
+					[&measure, &report, primitiveAmount, testMillions, &getHitDistances, scalarTime, scalarHitAmount, &doHitAmountsMatch](auto instructionSet)
+					{
+						using Lanes = FloatLanes<decltype(instructionSet)::value>;
+
+						int wideHitAmount;
+						const float wideTime{ measure([&getHitDistances, primitiveAmount](const Ray& ray)
+							{
+								int hitAmount{};
+								for (int index{}; index < primitiveAmount; index += Lanes::WIDTH)
+								{
+									typename Lanes::Type t;
+									hitAmount += std::popcount(static_cast<unsigned int>(getHitDistances(Lanes(), index, (1 << std::min(primitiveAmount - index, Lanes::WIDTH)) - 1, ray, t)));
+								}
+								return hitAmount;
+							}, wideHitAmount) };
+
+						report << ", " << GetInstructionSetName(decltype(instructionSet)::value) << " x" << Lanes::WIDTH << " = " << testMillions / wideTime << " M/s (x" << scalarTime / wideTime << ")";
+						doHitAmountsMatch &= wideHitAmount == scalarHitAmount;
+					});
+
+			report
+				<< "\n"
+				<< ">> HIT AMOUNTS " << (doHitAmountsMatch ? "MATCH" : "DIFFER") << '\n';
+		}
+	};
+
+	int scalarHitAmount;
+	const float scalarSphereTime{ measure([&vSpheres](const Ray& ray)
+		{
+			int hitAmount{};
+			for (const Sphere& sphere : vSpheres)
+				hitAmount += HitTestSphere(sphere, ray);
+			return hitAmount;
+		}, scalarHitAmount) };
+
+	report
+		<< "PRIMITIVE TESTS (" << primitiveAmount << " random spheres and planes)\n"
+		<< ">> SPHERE TESTS: SCALAR = " << testMillions / scalarSphereTime << " M/s";
+
+	reportWide([&wideSpheres](auto lanes, int index, int laneMask, const Ray& ray, auto& t)
+		{
+			return GetSphereHitDistances<decltype(lanes)>(wideSpheres, index, laneMask, ray, t);
+		}, scalarSphereTime, scalarHitAmount);
+
+	const float scalarPlaneTime{ measure([&vPlanes](const Ray& ray)
+		{
+			int hitAmount{};
+			for (const Plane& plane : vPlanes)
+				hitAmount += HitTestPlane(plane, ray);
+			return hitAmount;
+		}, scalarHitAmount) };
+
+	report << ">> PLANE TESTS: SCALAR = " << testMillions / scalarPlaneTime << " M/s";
+
+	reportWide([&widePlanes](auto lanes, int index, int laneMask, const Ray& ray, auto& t)
+		{
+			return GetPlaneHitDistances<decltype(lanes)>(widePlanes, index, laneMask, ray, t);
+		}, scalarPlaneTime, scalarHitAmount);
+	report << std::flush;
+}
+
+//	The results only have to agree within a tolerance, the reciprocal square root estimate and the different order of the additions change the last bits
+bool CheckSIMDMath(std::ostream& report)
+{
+#ifdef SIMD_MATH
+	static constexpr int INPUT_AMOUNT{ 4096 };
+	static constexpr float
+		INPUT_RANGE{ 10.0f },
+		TOLERANCE{ 1e-5f };
+
+	const auto getRandom
+	{
+		[]()
+		{
+			return Lerp(-INPUT_RANGE, INPUT_RANGE, static_cast<float>(rand()) / RAND_MAX);
+		}
+	};
+
+	//	Relative to the magnitude of the terms the reference adds up, sums that cancel out can't be more exact than their largest term
+	const auto track
+	{
+		[](float& maxError, float value, double reference, double magnitude)
+		{
+			maxError = std::max(maxError, static_cast<float>(std::abs(value - reference) / std::max({ 1.0, std::abs(reference), magnitude })));
+		}
+	};
+
+	const auto trackVector3
+	{
+		[&track](float& maxError, const Vector3& value, double referenceX, double referenceY, double referenceZ, double magnitude)
+		{
+			track(maxError, value.x, referenceX, magnitude);
+			track(maxError, value.y, referenceY, magnitude);
+			track(maxError, value.z, referenceZ, magnitude);
+		}
+	};
+
+	float
+		vector4Error{},
+		matrixError{},
+		normalizeError{},
+		vector3x8Error{},
+		colorRGBx8Error{};
+
+	for (int input{}; input < INPUT_AMOUNT; ++input)
+	{
+		const Vector4
+			vector1{ getRandom(), getRandom(), getRandom(), getRandom() },
+			vector2{ getRandom(), getRandom(), getRandom(), getRandom() };
+
+		const float scalar{ getRandom() };
+		const Vector4
+			sum{ vector1 + vector2 },
+			difference{ vector1 - vector2 },
+			product{ vector1 * scalar },
+			quotient{ vector1 / scalar },
+			normalized{ vector1.GetNormalized() };
+
+		double referenceMagnitude{};
+		for (int component{}; component < 4; ++component)
+			referenceMagnitude += double(vector1[component]) * vector1[component];
+
+		referenceMagnitude = std::sqrt(referenceMagnitude);
+
+		double
+			referenceDot{},
+			dotMagnitude{};
+		for (int component{}; component < 4; ++component)
+		{
+			const double termMagnitude{ std::abs(double(vector1[component])) + std::abs(vector2[component]) };
+			track(vector4Error, sum[component], double(vector1[component]) + vector2[component], termMagnitude);
+			track(vector4Error, difference[component], double(vector1[component]) - vector2[component], termMagnitude);
+			track(vector4Error, product[component], double(vector1[component]) * scalar, 0.0);
+			track(vector4Error, quotient[component], double(vector1[component]) / scalar, 0.0);
+			track(vector4Error, normalized[component], vector1[component] / referenceMagnitude, 0.0);
+			referenceDot += double(vector1[component]) * vector2[component];
+			dotMagnitude += std::abs(double(vector1[component]) * vector2[component]);
+		}
+
+		track(vector4Error, Vector4::Dot(vector1, vector2), referenceDot, dotMagnitude);
+
+		//	Arbitrary matrices for the product, an affine one for the transforms
+		Matrix matrix1, matrix2;
+		for (int row{}; row < 4; ++row)
+		{
+			matrix1[row] = Vector4{ getRandom(), getRandom(), getRandom(), getRandom() };
+			matrix2[row] = Vector4{ getRandom(), getRandom(), getRandom(), getRandom() };
+		}
+
+		const Matrix
+			matrixProduct{ matrix1 * matrix2 },
+			transposed{ matrix1.GetTransposed() };
+
+		for (int row{}; row < 4; ++row)
+			for (int column{}; column < 4; ++column)
+			{
+				double
+					referenceProduct{},
+					productMagnitude{};
+				for (int index{}; index < 4; ++index)
+				{
+					referenceProduct += double(matrix1[row][index]) * matrix2[index][column];
+					productMagnitude += std::abs(double(matrix1[row][index]) * matrix2[index][column]);
+				}
+
+				track(matrixError, matrixProduct[row][column], referenceProduct, productMagnitude);
+				track(matrixError, transposed[row][column], matrix1[column][row], 0.0);
+			}
+
+		const Matrix transform{ Matrix::CreateScalar(getRandom()) * Matrix::CreateRotor(getRandom(), getRandom(), getRandom()) * Matrix::CreateTranslator(getRandom(), getRandom(), getRandom()) };
+		const Vector3 point{ getRandom(), getRandom(), getRandom() };
+
+		const auto getReferenceTransform
+		{
+			[&transform](const Vector3& point, int axis, bool isPoint)
+			{
+				return double(point.x) * transform[0][axis] + double(point.y) * transform[1][axis] + double(point.z) * transform[2][axis] + (isPoint ? transform[3][axis] : 0.0);
+			}
+		};
+
+		//	Bounds the terms of every transformed component
+		double transformMagnitude{};
+		for (int row{}; row < 4; ++row)
+			for (int column{}; column < 3; ++column)
+				transformMagnitude = std::max(transformMagnitude, std::abs(double(transform[row][column])));
+
+		transformMagnitude *= 4.0 * INPUT_RANGE;
+
+		trackVector3(matrixError, transform.TransformPoint(point), getReferenceTransform(point, 0, true), getReferenceTransform(point, 1, true), getReferenceTransform(point, 2, true), transformMagnitude);
+		trackVector3(matrixError, transform.TransformVector(point), getReferenceTransform(point, 0, false), getReferenceTransform(point, 1, false), getReferenceTransform(point, 2, false), transformMagnitude);
+
+		const double pointMagnitude{ std::sqrt(double(point.x) * point.x + double(point.y) * point.y + double(point.z) * point.z) };
+		trackVector3(normalizeError, point.GetNormalized(), point.x / pointMagnitude, point.y / pointMagnitude, point.z / pointMagnitude, 0.0);
+
+		if (GetInstructionSet() == InstructionSet::SSE)
+			continue;
+
+		Vector3
+			aVectors1[Vector3x8::WIDTH],
+			aVectors2[Vector3x8::WIDTH],
+			aRoundTrip[Vector3x8::WIDTH];
+
+		ColorRGB
+			aColors1[ColorRGBx8::WIDTH],
+			aColors2[ColorRGBx8::WIDTH],
+			aColorResults[ColorRGBx8::WIDTH];
+
+		alignas(32) float aScalars[Vector3x8::WIDTH];
+
+		for (int lane{}; lane < Vector3x8::WIDTH; ++lane)
+		{
+			aVectors1[lane] = Vector3(getRandom(), getRandom(), getRandom());
+			aVectors2[lane] = Vector3(getRandom(), getRandom(), getRandom());
+			aColors1[lane] = ColorRGB(std::abs(getRandom()), std::abs(getRandom()), std::abs(getRandom()));
+			aColors2[lane] = ColorRGB(std::abs(getRandom()), std::abs(getRandom()), std::abs(getRandom()));
+			aScalars[lane] = getRandom();
+		}
+
+		const Vector3x8
+			vectors1{ Vector3x8::LoadInterleaved(aVectors1) },
+			vectors2{ Vector3x8::LoadInterleaved(aVectors2) },
+			cross{ Vector3x8::Cross(vectors1, vectors2) },
+			reflected{ Vector3x8::Reflect(vectors1, vectors2) },
+			normalizedVectors{ vectors1.GetNormalized() },
+			transformedPoints{ transform.TransformPoint(vectors1) };
+
+		vectors1.StoreInterleaved(aRoundTrip);
+
+		alignas(32) float aDots[Vector3x8::WIDTH];
+		_mm256_store_ps(aDots, Vector3x8::Dot(vectors1, vectors2));
+
+		const ColorRGBx8 colors{ (ColorRGBx8::Gather(aColors1) * ColorRGBx8::Gather(aColors2) + ColorRGBx8::Gather(aColors1) * _mm256_load_ps(aScalars)).GetMaxToOne() };
+		colors.Scatter(aColorResults);
+
+		for (int lane{}; lane < Vector3x8::WIDTH; ++lane)
+		{
+			const Vector3
+				& vector1{ aVectors1[lane] },
+				& vector2{ aVectors2[lane] };
+
+			const double
+				dot{ double(vector1.x) * vector2.x + double(vector1.y) * vector2.y + double(vector1.z) * vector2.z },
+				dotMagnitude{ std::abs(double(vector1.x) * vector2.x) + std::abs(double(vector1.y) * vector2.y) + std::abs(double(vector1.z) * vector2.z) },
+				magnitude{ std::sqrt(double(vector1.x) * vector1.x + double(vector1.y) * vector1.y + double(vector1.z) * vector1.z) };
+
+			trackVector3(vector3x8Error, vectors1.GetLane(lane), vector1.x, vector1.y, vector1.z, 0.0);
+			trackVector3(vector3x8Error, aRoundTrip[lane], vector1.x, vector1.y, vector1.z, 0.0);
+			track(vector3x8Error, aDots[lane], dot, dotMagnitude);
+			trackVector3(vector3x8Error, cross.GetLane(lane),
+				double(vector1.y) * vector2.z - double(vector1.z) * vector2.y,
+				double(vector1.z) * vector2.x - double(vector1.x) * vector2.z,
+				double(vector1.x) * vector2.y - double(vector1.y) * vector2.x,
+				2.0 * INPUT_RANGE * INPUT_RANGE);
+			trackVector3(vector3x8Error, reflected.GetLane(lane),
+				vector1.x - 2.0 * dot * vector2.x,
+				vector1.y - 2.0 * dot * vector2.y,
+				vector1.z - 2.0 * dot * vector2.z,
+				INPUT_RANGE + 2.0 * dotMagnitude * INPUT_RANGE);
+			trackVector3(vector3x8Error, normalizedVectors.GetLane(lane), vector1.x / magnitude, vector1.y / magnitude, vector1.z / magnitude, 0.0);
+			trackVector3(vector3x8Error, transformedPoints.GetLane(lane),
+				getReferenceTransform(vector1, 0, true),
+				getReferenceTransform(vector1, 1, true),
+				getReferenceTransform(vector1, 2, true),
+				transformMagnitude);
+
+			const double
+				red{ double(aColors1[lane].red) * aColors2[lane].red + double(aColors1[lane].red) * aScalars[lane] },
+				green{ double(aColors1[lane].green) * aColors2[lane].green + double(aColors1[lane].green) * aScalars[lane] },
+				blue{ double(aColors1[lane].blue) * aColors2[lane].blue + double(aColors1[lane].blue) * aScalars[lane] },
+				maxValue{ std::max({ red, green, blue, 1.0 }) },
+				colorMagnitude{ 2.0 * INPUT_RANGE * INPUT_RANGE / maxValue };
+
+			track(colorRGBx8Error, aColorResults[lane].red, red / maxValue, colorMagnitude);
+			track(colorRGBx8Error, aColorResults[lane].green, green / maxValue, colorMagnitude);
+			track(colorRGBx8Error, aColorResults[lane].blue, blue / maxValue, colorMagnitude);
+		}
+	}
+
+	const auto getResult
+	{
+		[](float maxError)
+		{
+			return maxError <= TOLERANCE ? "MATCH" : "DIFFER";
+		}
+	};
+
+	report
+		<< "SIMD MATH (" << INPUT_AMOUNT << " random inputs against the scalar reference, tolerance " << TOLERANCE << ")\n"
+		<< ">> VECTOR4 " << getResult(vector4Error) << " (max error " << vector4Error << ")\n"
+		<< ">> MATRIX " << getResult(matrixError) << " (max error " << matrixError << ")\n"
+		<< ">> VECTOR3 NORMALIZE " << getResult(normalizeError) << " (max error " << normalizeError << ")\n";
+
+	bool doesMatch{ vector4Error <= TOLERANCE && matrixError <= TOLERANCE && normalizeError <= TOLERANCE };
+	if (GetInstructionSet() != InstructionSet::SSE)
+	{
+		report
+			<< ">> VECTOR3x8 " << getResult(vector3x8Error) << " (max error " << vector3x8Error << ")\n"
+			<< ">> COLORRGBx8 " << getResult(colorRGBx8Error) << " (max error " << colorRGBx8Error << ")\n";
+
+		doesMatch = doesMatch && vector3x8Error <= TOLERANCE && colorRGBx8Error <= TOLERANCE;
+	}
+
+	report << std::flush;
+	return doesMatch;
+#else
+	report << "SIMD MATH DISABLED, NOTHING TO COMPARE AGAINST THE SCALAR REFERENCE" << std::endl;
+	return true;
+#endif
+}
+
+void RunAccelerationBenchmark(const Scene& scene)
+{
+	system("CLS");
+	std::cout
+		<< CONTROLS
+		<< "--------\n"
+		<< "ACCELERATION BENCHMARK STARTED\n"
+		<< "--------\n";
+
+	std::stringstream report;
+	report << "INSTRUCTION SET: " << GetInstructionSetName(GetInstructionSet()) << std::endl;
+	CheckSIMDMath(report);
+	BenchmarkScene(scene, report);
+
+	for (const TriangleMesh& triangleMesh : scene.GetTriangleMeshes())
+	{
+		BenchmarkTriangleMesh(triangleMesh, scene.GetCamera().GetOrigin(), true, report);
+		BenchmarkTriangleIntersection(triangleMesh, scene.GetCamera().GetOrigin(), report);
+	}
+
+	static constexpr int
+		LARGE_GEOMETRY_RESOLUTION{ 512 },
+		SLIVER_CELL_AMOUNT{ 64 },
+		PARTICLE_AMOUNT{ 512 };
+
+	const Vector3 generatedGeometryOrigin{ 0.0f, 0.0f, -15.0f };
+
+	BenchmarkPrimitiveIntersection(PARTICLE_AMOUNT, generatedGeometryOrigin, AABB(Vector3(-5.0f, -5.0f, 0.0f), Vector3(5.0f, 5.0f, 10.0f)), report);
+
+	const std::shared_ptr<TriangleMeshGeometry> pLargeGeometry{ GenerateLargeGeometry(LARGE_GEOMETRY_RESOLUTION) };
+	BenchmarkTriangleMesh(TriangleMesh(pLargeGeometry, 0, Triangle::CullMode::none), generatedGeometryOrigin, false, report);
+	BenchmarkBuildQualities(pLargeGeometry, { BVHBuildQuality::linear, BVHBuildQuality::fast }, generatedGeometryOrigin, report);
+
+	BenchmarkBuildQualities(GenerateSliverGeometry(SLIVER_CELL_AMOUNT), { BVHBuildQuality::fast, BVHBuildQuality::spatialSplits }, generatedGeometryOrigin, report);
+
+	system("CLS");
+	std::cout
+		<< CONTROLS
+		<< "--------\n"
+		<< "ACCELERATION BENCHMARK FINISHED\n"
+		<< report.str()
+		<< "--------\n";
+
+	std::ofstream fileStream("acceleration_benchmark.txt");
+	fileStream << report.str();
+	fileStream.close();
+}
\ No newline at end of file
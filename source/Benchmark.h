@@ -0,0 +1,12 @@
+#pragma once
+
+#include <ostream>
+
+class Scene;
+
+//	Compares the SIMD math implementations against scalar reference code on random inputs, writes the results to the report
+//	and returns whether all of them matched. Doesn't need a window, so it can run from the command line as well
+bool CheckSIMDMath(std::ostream& report);
+
+//	Times the acceleration structures of the scene against their reference paths, prints the results and saves them to "acceleration_benchmark.txt"
+void RunAccelerationBenchmark(const Scene& scene);
\ No newline at end of file
@@ -90,4 +90,28 @@ void Camera::Update(const Timer& timer)
 		m_Origin += m_RightDirection * deltaTime * MOVEMENT_SPEED;
 		m_DidMove = true;
 	}
+}
+
+CameraLatch::CameraLatch(const Camera& camera) :
+	m_Mutex{},
+
+	m_Camera{ camera },
+	m_InputTime{ SDL_GetPerformanceCounter() }
+{
+}
+
+void CameraLatch::Store(const Camera& camera)
+{
+	const uint64_t inputTime{ SDL_GetPerformanceCounter() };
+
+	const std::lock_guard lock{ m_Mutex };
+	m_Camera = camera;
+	m_InputTime = inputTime;
+}
+
+Camera CameraLatch::Load(uint64_t& inputTime) const
+{
+	const std::lock_guard lock{ m_Mutex };
+	inputTime = m_InputTime;
+	return m_Camera;
 }
\ No newline at end of file
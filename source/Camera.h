@@ -1,6 +1,7 @@
 #pragma once
 
 #include <iostream>
+#include <mutex>
 
 #include "Constants.hpp"
 #include "Matrix.hpp"
@@ -88,4 +89,30 @@ private:
 	Matrix m_CameraToWorld;
 
 	bool m_DidMove;
+};
+
+//	Hands the newest camera from the thread sampling the input to the render thread, which latches it right before
+//	generating the camera rays instead of using the camera the frame started with
+class CameraLatch final
+{
+public:
+	explicit CameraLatch(const Camera& camera);
+	~CameraLatch() = default;
+
+	CameraLatch(const CameraLatch&) = delete;
+	CameraLatch(CameraLatch&&) noexcept = delete;
+	CameraLatch& operator=(const CameraLatch&) = delete;
+	CameraLatch& operator=(CameraLatch&&) noexcept = delete;
+
+	//	Remembers when the input the camera follows was sampled
+	void Store(const Camera& camera);
+
+	//	Also returns the performance counter of the input sample, to measure the input to present latency
+	Camera Load(uint64_t& inputTime) const;
+
+private:
+	mutable std::mutex m_Mutex;
+
+	Camera m_Camera;
+	uint64_t m_InputTime;
 };
\ No newline at end of file
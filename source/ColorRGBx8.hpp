@@ -0,0 +1,108 @@
+#pragma once
+
+#include "ColorRGB.hpp"
+#include "SIMD.hpp"
+
+#ifdef SIMD_MATH
+//	Eight colors with every channel in its own AVX register, the lane-wide counterpart of ColorRGB for structure of arrays paths
+struct ColorRGBx8
+{
+public:
+	static constexpr int WIDTH{ 8 };
+
+	static inline ColorRGBx8 Broadcast(const ColorRGB& color)
+	{
+		return ColorRGBx8
+		(
+			_mm256_set1_ps(color.red),
+			_mm256_set1_ps(color.green),
+			_mm256_set1_ps(color.blue)
+		);
+	}
+
+	//	Transposes eight consecutive colors of an array of ColorRGB
+	static inline ColorRGBx8 Gather(const ColorRGB* pColors)
+	{
+		return ColorRGBx8
+		(
+			_mm256_setr_ps(pColors[0].red, pColors[1].red, pColors[2].red, pColors[3].red, pColors[4].red, pColors[5].red, pColors[6].red, pColors[7].red),
+			_mm256_setr_ps(pColors[0].green, pColors[1].green, pColors[2].green, pColors[3].green, pColors[4].green, pColors[5].green, pColors[6].green, pColors[7].green),
+			_mm256_setr_ps(pColors[0].blue, pColors[1].blue, pColors[2].blue, pColors[3].blue, pColors[4].blue, pColors[5].blue, pColors[6].blue, pColors[7].blue)
+		);
+	}
+
+	inline void Scatter(ColorRGB* pColors) const
+	{
+		alignas(32) float aRed[WIDTH], aGreen[WIDTH], aBlue[WIDTH];
+		_mm256_store_ps(aRed, red);
+		_mm256_store_ps(aGreen, green);
+		_mm256_store_ps(aBlue, blue);
+
+		for (int lane{}; lane < WIDTH; ++lane)
+			pColors[lane] = ColorRGB(aRed[lane], aGreen[lane], aBlue[lane]);
+	}
+
+	inline ColorRGBx8 GetMaxToOne() const
+	{
+		const __m256
+			maxValue{ _mm256_max_ps(red, _mm256_max_ps(green, blue)) },
+			one{ _mm256_set1_ps(1.0f) };
+
+		return *this / _mm256_max_ps(maxValue, one);
+	}
+
+	inline ColorRGBx8& MaxToOne()
+	{
+		*this = GetMaxToOne();
+		return *this;
+	}
+
+	inline ColorRGBx8 operator*(const ColorRGBx8& color) const
+	{
+		return ColorRGBx8(_mm256_mul_ps(red, color.red), _mm256_mul_ps(green, color.green), _mm256_mul_ps(blue, color.blue));
+	}
+
+	inline ColorRGBx8 operator*(__m256 scalars) const
+	{
+		return ColorRGBx8(_mm256_mul_ps(red, scalars), _mm256_mul_ps(green, scalars), _mm256_mul_ps(blue, scalars));
+	}
+
+	inline ColorRGBx8 operator/(__m256 scalars) const
+	{
+		return ColorRGBx8(_mm256_div_ps(red, scalars), _mm256_div_ps(green, scalars), _mm256_div_ps(blue, scalars));
+	}
+
+	inline ColorRGBx8 operator+(const ColorRGBx8& color) const
+	{
+		return ColorRGBx8(_mm256_add_ps(red, color.red), _mm256_add_ps(green, color.green), _mm256_add_ps(blue, color.blue));
+	}
+
+	inline ColorRGBx8 operator-(const ColorRGBx8& color) const
+	{
+		return ColorRGBx8(_mm256_sub_ps(red, color.red), _mm256_sub_ps(green, color.green), _mm256_sub_ps(blue, color.blue));
+	}
+
+	inline const ColorRGBx8& operator*=(const ColorRGBx8& color)
+	{
+		*this = *this * color;
+		return *this;
+	}
+
+	inline const ColorRGBx8& operator*=(__m256 scalars)
+	{
+		*this = *this * scalars;
+		return *this;
+	}
+
+	inline const ColorRGBx8& operator+=(const ColorRGBx8& color)
+	{
+		*this = *this + color;
+		return *this;
+	}
+
+	__m256
+		red,
+		green,
+		blue;
+};
+#endif
\ No newline at end of file
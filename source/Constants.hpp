@@ -7,10 +7,14 @@ constexpr char CONTROLS[]
 	"WASD:	 Move Camera\n"
 	"F2:	 Toggle Shadows\n"
 	"F3:	 Cycle Lighting Modes\n"
+	"F4:	 Toggle Wavefront Rendering\n"
+	"F5:	 Toggle Reflections\n"
 	"F6:      Start Benchmark\n"
-#ifdef REFLECT
+	"F7:      Start Acceleration Benchmark\n"
+	"F8:      Cycle Reflection Samplers\n"
+	"F9:      Toggle Skipping Unchanged Frames\n"
+	"F10:     Toggle Interactive Preview\n"
 	"UP/DOWN: In-/decrement Reflection Bounces\n"
-#endif
 	"SCROLL:  In-/decrease Field Of View\n"
 	"X:       Take Screenshot\n"
 };
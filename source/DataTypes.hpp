@@ -2,14 +2,21 @@
 
 #include <string>
 #include <vector>
+#include <memory>
 #include <fstream>
+#include <map>
+#include <bit>
 
 #include "Matrix.hpp"
+#include "BVH.hpp"
 #include "ColorRGB.hpp"
+#include "InstructionSet.hpp"
 
 struct Sphere
 {
 public:
+	bool operator==(const Sphere& sphere) const = default;
+
 	Vector3 origin;
 	float radius;
 
@@ -19,6 +26,8 @@ public:
 struct Plane
 {
 public:
+	bool operator==(const Plane& plane) const = default;
+
 	Vector3
 		origin,
 		normal;
@@ -26,6 +35,96 @@ public:
 	unsigned char materialIndex;
 };
 
+//	Spheres in structure of arrays layout, so they can be tested a register width at a time
+struct WideSpheres
+{
+public:
+	enum Component
+	{
+		originX, originY, originZ,
+		radius,
+		radiusSquared,
+		componentAmount
+	};
+
+	//	Lays the spheres out in the order of vObjectIndices, which can reference other objects from sphereAmount onwards.
+	//	Their slots get an infinitely negative squared radius, so the discriminant can never be positive
+	inline void Build(const std::vector<Sphere>& vSpheres, const std::vector<int>& vObjectIndices)
+	{
+		//	Padding, so the last leaf can load a full register of the widest instruction set
+		stride = static_cast<int>(vObjectIndices.size()) + MAX_LANE_WIDTH - 1;
+		vComponents.assign(componentAmount * stride, 0.0f);
+		vMaterialIndices.assign(stride, 0);
+
+		std::fill_n(vComponents.begin() + radiusSquared * stride, stride, -INFINITY);
+		for (int index{}; index < vObjectIndices.size(); ++index)
+		{
+			if (vObjectIndices[index] >= vSpheres.size())
+				continue;
+
+			const Sphere& sphere{ vSpheres[vObjectIndices[index]] };
+			vComponents[originX * stride + index] = sphere.origin.x;
+			vComponents[originY * stride + index] = sphere.origin.y;
+			vComponents[originZ * stride + index] = sphere.origin.z;
+			vComponents[radius * stride + index] = sphere.radius;
+			vComponents[radiusSquared * stride + index] = sphere.radius * sphere.radius;
+			vMaterialIndices[index] = sphere.materialIndex;
+		}
+	}
+
+	inline const float* GetComponent(Component component, int index) const
+	{
+		return &vComponents[component * stride + index];
+	}
+
+	std::vector<float> vComponents;
+	std::vector<unsigned char> vMaterialIndices;
+	int stride{};
+};
+
+//	Planes in structure of arrays layout with the distance term dot(origin, normal) precomputed, so they can be tested a register width at a time
+struct WidePlanes
+{
+public:
+	enum Component
+	{
+		normalX, normalY, normalZ,
+		originDotNormal,
+		componentAmount
+	};
+
+	inline void Build(const std::vector<Plane>& vPlanes)
+	{
+		amount = static_cast<int>(vPlanes.size());
+
+		//	Padding, so the last planes can load a full register of the widest instruction set
+		stride = amount + MAX_LANE_WIDTH - 1;
+		vComponents.assign(componentAmount * stride, 0.0f);
+		vMaterialIndices.assign(stride, 0);
+
+		for (int index{}; index < amount; ++index)
+		{
+			const Plane& plane{ vPlanes[index] };
+			vComponents[normalX * stride + index] = plane.normal.x;
+			vComponents[normalY * stride + index] = plane.normal.y;
+			vComponents[normalZ * stride + index] = plane.normal.z;
+			vComponents[originDotNormal * stride + index] = Vector3::Dot(plane.origin, plane.normal);
+			vMaterialIndices[index] = plane.materialIndex;
+		}
+	}
+
+	inline const float* GetComponent(Component component, int index) const
+	{
+		return &vComponents[component * stride + index];
+	}
+
+	std::vector<float> vComponents;
+	std::vector<unsigned char> vMaterialIndices;
+	int
+		amount{},
+		stride{};
+};
+
 struct Triangle
 {
 public:
@@ -47,111 +146,268 @@ public:
 
 };
 
-struct TriangleMesh
+//	Moller-Trumbore layout, precomputed once per triangle so the hit test only needs the ray
+struct PrecomputedTriangle
 {
 public:
-	TriangleMesh(unsigned char materialIndex, Triangle::CullMode cullMode = Triangle::CullMode::backFace) :
-		smallestAABB{}, smallestAABBTransformed{},
-		largestAABB{}, largestAABBTransformed{},
+	PrecomputedTriangle() = default;
 
-		vPositions{}, vPositionsTransformed{},
-		vNormals{}, vNormalsTransformed{},
+	PrecomputedTriangle(const Vector3& _v0, const Vector3& v1, const Vector3& v2, const Vector3& _normal) :
+		v0{ _v0 },
+		edge1{ v1 - _v0 },
+		edge2{ v2 - _v0 },
+		normal{ _normal }
+	{
+	}
 
-		vIndices{},
+	Vector3
+		v0,
+		edge1,
+		edge2,
+		normal;
 
-		materialIndex{ materialIndex },
-		cullMode{ cullMode },
+};
 
-		translator{ IDENTITY },
-		rotor{ IDENTITY },
-		scalar{ IDENTITY },
-		finalTransform{ IDENTITY }
+//	The precomputed triangles in BVH primitive order with every component in its own array, so any consecutive triangles of a leaf
+//	load into one register per component, four for SSE up to sixteen for AVX-512
+struct WideTriangles
+{
+public:
+	enum Component
+	{
+		v0X, v0Y, v0Z,
+		edge1X, edge1Y, edge1Z,
+		edge2X, edge2Y, edge2Z,
+		normalX, normalY, normalZ,
+		componentAmount
+	};
+
+	inline void Build(const std::vector<PrecomputedTriangle>& vTriangles, const std::vector<int>& vPrimitiveIndices)
+	{
+		//	Padding, so the last leaf can load a full register of the widest instruction set
+		stride = static_cast<int>(vPrimitiveIndices.size()) + MAX_LANE_WIDTH - 1;
+		vComponents.assign(componentAmount * stride, 0.0f);
+
+		for (int index{}; index < vPrimitiveIndices.size(); ++index)
+		{
+			const PrecomputedTriangle& triangle{ vTriangles[vPrimitiveIndices[index]] };
+			const Vector3* apVectors[]{ &triangle.v0, &triangle.edge1, &triangle.edge2, &triangle.normal };
+			for (int vectorIndex{}; vectorIndex < 4; ++vectorIndex)
+				for (int axis{}; axis < 3; ++axis)
+					vComponents[(3 * vectorIndex + axis) * stride + index] = (*apVectors[vectorIndex])[axis];
+		}
+	}
+
+	inline const float* GetComponent(Component component, int index) const
 	{
+		return &vComponents[component * stride + index];
 	}
 
-	TriangleMesh(const std::string& OBJFilePath, unsigned char materialIndex, Triangle::CullMode cullMode = Triangle::CullMode::backFace) :
+	std::vector<float> vComponents;
+	int stride;
+
+};
+
+//	Object space geometry that gets shared between every TriangleMesh instancing it
+struct TriangleMeshGeometry
+{
+public:
+	TriangleMeshGeometry() :
+		smallestAABB{},
+		largestAABB{},
+
 		vPositions{},
 		vNormals{},
 
 		vIndices{},
 
-		materialIndex{ materialIndex },
-		cullMode(cullMode),
+		vPrecomputedTriangles{},
+		wideTriangles{},
 
-		translator{ IDENTITY },
-		rotor{ IDENTITY },
-		scalar{ IDENTITY },
-		finalTransform{ IDENTITY }
+		bvh{},
+		bvhBuildQuality{ BVHBuildQuality::fast },
+
+		fingerprint{}
+	{
+	}
+
+	TriangleMeshGeometry(const std::string& OBJFilePath, BVHBuildQuality _bvhBuildQuality = BVHBuildQuality::fast) :
+		TriangleMeshGeometry()
 	{
+		bvhBuildQuality = _bvhBuildQuality;
 		ParseOBJ(OBJFilePath);
 
 		CalculateNormals();
+		PrecomputeTriangles();
 		UpdateAABB();
-		UpdateTransforms();
+		BuildBVH();
 	}
 
-	inline void AppendTriangle(const Triangle& triangle)
+	TriangleMeshGeometry(std::vector<Vector3>&& _vPositions, std::vector<int>&& _vIndices, BVHBuildQuality _bvhBuildQuality = BVHBuildQuality::fast) :
+		TriangleMeshGeometry()
+	{
+		bvhBuildQuality = _bvhBuildQuality;
+		vPositions = std::move(_vPositions);
+		vIndices = std::move(_vIndices);
+
+		CalculateNormals();
+		PrecomputeTriangles();
+		UpdateAABB();
+		BuildBVH();
+	}
+
+	//	Loading the same OBJ file again returns the already loaded geometry as long as a TriangleMesh still uses it
+	static inline std::shared_ptr<TriangleMeshGeometry> Load(const std::string& OBJFilePath, BVHBuildQuality bvhBuildQuality = BVHBuildQuality::fast)
+	{
+		static std::map<std::pair<std::string, BVHBuildQuality>, std::weak_ptr<TriangleMeshGeometry>> mLoadedGeometries{};
+
+		std::weak_ptr<TriangleMeshGeometry>& pLoadedGeometry{ mLoadedGeometries[{ OBJFilePath, bvhBuildQuality }] };
+		if (std::shared_ptr<TriangleMeshGeometry> pGeometry{ pLoadedGeometry.lock() })
+			return pGeometry;
+
+		std::shared_ptr<TriangleMeshGeometry> pGeometry{ std::make_shared<TriangleMeshGeometry>(OBJFilePath, bvhBuildQuality) };
+		pLoadedGeometry = pGeometry;
+		return pGeometry;
+	}
+
+	//	The bounds and the BVH stay stale until FinishAppending, so geometry appended a triangle at a time only gets built once
+	inline void AppendTriangle(const Vector3& v0, const Vector3& v1, const Vector3& v2)
 	{
 		const int startingIndex{ static_cast<int>(vPositions.size()) };
 
-		vPositions.push_back(triangle.v0);
-		vPositions.push_back(triangle.v1);
-		vPositions.push_back(triangle.v2);
+		vPositions.push_back(v0);
+		vPositions.push_back(v1);
+		vPositions.push_back(v2);
 
 		vIndices.push_back(startingIndex);
 		vIndices.push_back(startingIndex + 1);
 		vIndices.push_back(startingIndex + 2);
 
-		CalculateNormals();
-		UpdateAABB();
-		UpdateTransforms(startingIndex);
+		vNormals.push_back(Vector3::Cross((v1 - v0), (v2 - v0)).GetNormalized());
+		vPrecomputedTriangles.emplace_back(v0, v1, v2, vNormals.back());
 	}
 
-	inline void UpdateTransforms(int startingIndex = 0)
+	inline void FinishAppending()
 	{
-		vPositionsTransformed.resize(vPositions.size());
-		for (int index{ startingIndex }; index < vPositions.size(); ++index)
-			vPositionsTransformed[index] = finalTransform.TransformPoint(vPositions[index]);
+		UpdateAABB();
+		BuildBVH();
+	}
 
-		vNormalsTransformed.resize(vNormals.size());
-		for (int index{ startingIndex }; index < vNormals.size(); ++index)
-			vNormalsTransformed[index] = finalTransform.TransformVector(vNormals[index]).GetNormalized();
+	//	Bakes a transform into the vertices for deforming geometry, rigidly moving instances only need their TriangleMesh transform.
+	//	The BVH only gets refitted unless it has spatial splits, so its quality degrades when the triangles move relative to each other
+	inline void Transform(const Matrix& transform)
+	{
+		transform.TransformPoints(vPositions.data(), vPositions.data(), static_cast<int>(vPositions.size()));
+		transform.TransformNormals(vNormals.data(), vNormals.data(), static_cast<int>(vNormals.size()));
 
-		UpdateAABBTransformed();
+		PrecomputeTriangles();
+		UpdateAABB();
+		RefitBVH();
 	}
 
-	inline void SetTranslator(const Vector3& _translator)
+	inline int GetTriangleAmount() const
 	{
-		this->translator = Matrix::CreateTranslator(_translator);
-		finalTransform = scalar * rotor * this->translator;
+		return static_cast<int>(vIndices.size() / 3);
 	}
 
-	inline void SetRotorY(float _yaw)
+	//	Rebuilds the BVH with the current bvhBuildQuality
+	inline void BuildBVH()
 	{
-		rotor = Matrix::CreateRotorY(_yaw);
-		finalTransform = scalar * rotor * translator;
+		const std::vector<AABB> vTriangleBounds{ GetTriangleBounds() };
+
+		if (bvhBuildQuality == BVHBuildQuality::spatialSplits)
+		{
+			bvh.BuildWithSpatialSplits(vTriangleBounds, SPATIAL_SPLIT_REFERENCE_GROWTH_LIMIT,
+				[this](int triangleIndex, int axis, float position, AABB& leftBounds, AABB& rightBounds)
+				{
+					for (int vertexIndex{}; vertexIndex < 3; ++vertexIndex)
+					{
+						const Vector3
+							& v0{ vPositions[vIndices[3 * triangleIndex + vertexIndex]] },
+							& v1{ vPositions[vIndices[3 * triangleIndex + (vertexIndex + 1) % 3]] };
+
+						if (v0[axis] <= position)
+							leftBounds.Grow(v0);
+
+						if (v0[axis] >= position)
+							rightBounds.Grow(v0);
+
+						//	The edge crosses the plane
+						if ((v0[axis] < position && v1[axis] > position) || (v0[axis] > position && v1[axis] < position))
+						{
+							Vector3 intersection{ v0 + (v1 - v0) * ((position - v0[axis]) / (v1[axis] - v0[axis])) };
+							intersection[axis] = position;
+
+							leftBounds.Grow(intersection);
+							rightBounds.Grow(intersection);
+						}
+					}
+				});
+		}
+		else if (bvhBuildQuality == BVHBuildQuality::linear)
+			bvh.BuildLinear(vTriangleBounds);
+		else
+			bvh.Build(vTriangleBounds);
+
+		bvh.BuildLayout(bvh.GetLayout());
+
+		wideTriangles.Build(vPrecomputedTriangles, bvh.GetPrimitiveIndices());
+		UpdateFingerprint();
 	}
 
-	inline void SetScalar(float _scalar)
+	//	Keeps the hierarchy of the last build and only updates its bounds, the triangle amount has to be the same.
+	//	Spatial split references are clipped to their nodes and refitting would grow them back to the whole triangles, those get rebuilt
+	inline void RefitBVH()
 	{
-		this->scalar = Matrix::CreateScalar(_scalar);
-		finalTransform = this->scalar * rotor * translator;
+		if (bvhBuildQuality == BVHBuildQuality::spatialSplits)
+		{
+			BuildBVH();
+			return;
+		}
+
+		bvh.Refit(GetTriangleBounds());
+		bvh.BuildLayout(bvh.GetLayout());
+
+		wideTriangles.Build(vPrecomputedTriangles, bvh.GetPrimitiveIndices());
+		UpdateFingerprint();
 	}
 
 	Vector3
-		smallestAABB, smallestAABBTransformed,
-		largestAABB, largestAABBTransformed;
+		smallestAABB,
+		largestAABB;
 
 	std::vector<Vector3>
-		vPositionsTransformed,
-		vNormalsTransformed;
+		vPositions,
+		vNormals;
 
 	std::vector<int> vIndices;
 
-	unsigned char materialIndex;
-	Triangle::CullMode cullMode;
+	std::vector<PrecomputedTriangle> vPrecomputedTriangles;
+	WideTriangles wideTriangles;
+
+	BVH bvh;
+	BVHBuildQuality bvhBuildQuality;
+
+	//	Of the vertices and the triangles, so the same geometry in both scenes of the double-buffered update compares equal
+	uint64_t fingerprint;
 
 private:
+	inline void UpdateFingerprint()
+	{
+		const auto mix{ [this](uint32_t value) { fingerprint = (fingerprint ^ value) * 1099511628211ull; } };
+
+		fingerprint = 14695981039346656037ull;
+		for (const Vector3& position : vPositions)
+		{
+			mix(std::bit_cast<uint32_t>(position.x));
+			mix(std::bit_cast<uint32_t>(position.y));
+			mix(std::bit_cast<uint32_t>(position.z));
+		}
+
+		for (int index : vIndices)
+			mix(static_cast<uint32_t>(index));
+	}
+
 	inline bool ParseOBJ(const std::string& OBJFilePath)
 	{
 		std::ifstream file(OBJFilePath);
@@ -208,6 +464,28 @@ private:
 		}
 	}
 
+	inline void PrecomputeTriangles()
+	{
+		vPrecomputedTriangles.clear();
+		vPrecomputedTriangles.reserve(GetTriangleAmount());
+		for (int index{}; index < GetTriangleAmount(); ++index)
+			vPrecomputedTriangles.emplace_back(
+				vPositions[vIndices[3 * index]],
+				vPositions[vIndices[3 * index + 1]],
+				vPositions[vIndices[3 * index + 2]],
+				vNormals[index]);
+	}
+
+	inline std::vector<AABB> GetTriangleBounds() const
+	{
+		std::vector<AABB> vTriangleBounds(GetTriangleAmount());
+		for (int index{}; index < vTriangleBounds.size(); ++index)
+			for (int vertexIndex{}; vertexIndex < 3; ++vertexIndex)
+				vTriangleBounds[index].Grow(vPositions[vIndices[3 * index + vertexIndex]]);
+
+		return vTriangleBounds;
+	}
+
 	inline void UpdateAABB()
 	{
 		if (vPositions.size())
@@ -222,53 +500,174 @@ private:
 		}
 	}
 
-	inline void UpdateAABBTransformed()
+};
+
+//	An instance of (possibly shared) geometry, rays get transformed into its object space instead of transforming the geometry
+struct TriangleMesh
+{
+public:
+	TriangleMesh(unsigned char materialIndex, Triangle::CullMode cullMode = Triangle::CullMode::backFace) :
+		smallestAABBTransformed{},
+		largestAABBTransformed{},
+
+		materialIndex{ materialIndex },
+		cullMode{ cullMode },
+
+		pGeometry{ std::make_shared<TriangleMeshGeometry>() },
+
+		translator{ IDENTITY },
+		rotor{ IDENTITY },
+		scalar{ IDENTITY },
+		finalTransform{ IDENTITY },
+		inverseTransform{ IDENTITY }
+	{
+	}
+
+	TriangleMesh(const std::string& OBJFilePath, unsigned char materialIndex, Triangle::CullMode cullMode = Triangle::CullMode::backFace, BVHBuildQuality bvhBuildQuality = BVHBuildQuality::fast) :
+		smallestAABBTransformed{},
+		largestAABBTransformed{},
+
+		materialIndex{ materialIndex },
+		cullMode(cullMode),
+
+		pGeometry{ TriangleMeshGeometry::Load(OBJFilePath, bvhBuildQuality) },
+
+		translator{ IDENTITY },
+		rotor{ IDENTITY },
+		scalar{ IDENTITY },
+		finalTransform{ IDENTITY },
+		inverseTransform{ IDENTITY }
+	{
+		UpdateTransforms();
+	}
+
+	TriangleMesh(const std::shared_ptr<TriangleMeshGeometry>& pGeometry, unsigned char materialIndex, Triangle::CullMode cullMode = Triangle::CullMode::backFace) :
+		smallestAABBTransformed{},
+		largestAABBTransformed{},
+
+		materialIndex{ materialIndex },
+		cullMode(cullMode),
+
+		pGeometry{ pGeometry },
+
+		translator{ IDENTITY },
+		rotor{ IDENTITY },
+		scalar{ IDENTITY },
+		finalTransform{ IDENTITY },
+		inverseTransform{ IDENTITY }
 	{
-		Vector3 
-			tSmallestAABB{ finalTransform.TransformPoint(smallestAABB) },
-			tLargestAABB{ tSmallestAABB };
+		UpdateTransforms();
+	}
 
-		Vector3 tAABB{ finalTransform.TransformPoint(largestAABB.x, smallestAABB.y, smallestAABB.z) };
-		tSmallestAABB = Vector3::GetSmallestComponents(tAABB, tSmallestAABB);
-		tLargestAABB = Vector3::GetLargestComponents(tAABB, tLargestAABB);
+	//	The geometry gets copied first when other instances share it. FinishAppending has to follow the last appended triangle
+	inline void AppendTriangle(const Triangle& triangle)
+	{
+		if (pGeometry.use_count() > 1)
+			pGeometry = std::make_shared<TriangleMeshGeometry>(*pGeometry);
 
-		tAABB = finalTransform.TransformPoint(largestAABB.x, smallestAABB.y, largestAABB.z);
-		tSmallestAABB = Vector3::GetSmallestComponents(tAABB, tSmallestAABB);
-		tLargestAABB = Vector3::GetLargestComponents(tAABB, tLargestAABB);
+		pGeometry->AppendTriangle(triangle.v0, triangle.v1, triangle.v2);
+	}
 
-		tAABB = finalTransform.TransformPoint(smallestAABB.x, smallestAABB.y, largestAABB.z);
-		tSmallestAABB = Vector3::GetSmallestComponents(tAABB, tSmallestAABB);
-		tLargestAABB = Vector3::GetLargestComponents(tAABB, tLargestAABB);
+	inline void FinishAppending()
+	{
+		if (pGeometry.use_count() > 1)
+			pGeometry = std::make_shared<TriangleMeshGeometry>(*pGeometry);
 
-		tAABB = finalTransform.TransformPoint(smallestAABB.x, largestAABB.y, smallestAABB.z);
-		tSmallestAABB = Vector3::GetSmallestComponents(tAABB, tSmallestAABB);
-		tLargestAABB = Vector3::GetLargestComponents(tAABB, tLargestAABB);
+		pGeometry->FinishAppending();
+		UpdateTransforms();
+	}
 
-		tAABB = finalTransform.TransformPoint(largestAABB.x, largestAABB.y, smallestAABB.z);
-		tSmallestAABB = Vector3::GetSmallestComponents(tAABB, tSmallestAABB);
-		tLargestAABB = Vector3::GetLargestComponents(tAABB, tLargestAABB);
+	//	Copy on write as well, the other instances keep the untransformed geometry
+	inline void TransformGeometry(const Matrix& transform)
+	{
+		if (pGeometry.use_count() > 1)
+			pGeometry = std::make_shared<TriangleMeshGeometry>(*pGeometry);
 
-		tAABB = finalTransform.TransformPoint(largestAABB);
-		tSmallestAABB = Vector3::GetSmallestComponents(tAABB, tSmallestAABB);
-		tLargestAABB = Vector3::GetLargestComponents(tAABB, tLargestAABB);
+		pGeometry->Transform(transform);
+		UpdateTransforms();
+	}
 
-		tAABB = finalTransform.TransformPoint(smallestAABB.x, largestAABB.y, smallestAABB.z);
-		tSmallestAABB = Vector3::GetSmallestComponents(tAABB, tSmallestAABB);
-		tLargestAABB = Vector3::GetLargestComponents(tAABB, tLargestAABB);
+	inline void UpdateTransforms()
+	{
+		inverseTransform = finalTransform.GetAffineInverse();
+		UpdateAABBTransformed();
+	}
 
-		smallestAABBTransformed = tSmallestAABB;
-		largestAABBTransformed = tLargestAABB;
+	inline void SetTranslator(const Vector3& _translator)
+	{
+		this->translator = Matrix::CreateTranslator(_translator);
+		finalTransform = scalar * rotor * this->translator;
 	}
 
-	std::vector<Vector3>
-		vPositions,
-		vNormals;
+	inline void SetRotorY(float _yaw)
+	{
+		rotor = Matrix::CreateRotorY(_yaw);
+		finalTransform = scalar * rotor * translator;
+	}
+
+	inline void SetScalar(float _scalar)
+	{
+		this->scalar = Matrix::CreateScalar(_scalar);
+		finalTransform = this->scalar * rotor * translator;
+	}
+
+	inline const TriangleMeshGeometry& GetGeometry() const
+	{
+		return *pGeometry;
+	}
+
+	inline const Matrix& GetTransform() const
+	{
+		return finalTransform;
+	}
+
+	inline const Matrix& GetInverseTransform() const
+	{
+		return inverseTransform;
+	}
+
+	Vector3
+		smallestAABBTransformed,
+		largestAABBTransformed;
+
+	unsigned char materialIndex;
+	Triangle::CullMode cullMode;
+
+private:
+	inline void UpdateAABBTransformed()
+	{
+		const Vector3
+			& smallestAABB{ pGeometry->smallestAABB },
+			& largestAABB{ pGeometry->largestAABB };
+
+		Vector3 aCorners[8];
+		for (int corner{}; corner < 8; ++corner)
+			aCorners[corner] = Vector3
+			(
+				(corner & 1) ? largestAABB.x : smallestAABB.x,
+				(corner & 2) ? largestAABB.y : smallestAABB.y,
+				(corner & 4) ? largestAABB.z : smallestAABB.z
+			);
+
+		finalTransform.TransformPoints(aCorners, aCorners, 8);
+
+		smallestAABBTransformed = aCorners[0];
+		largestAABBTransformed = aCorners[0];
+		for (const Vector3& corner : aCorners)
+		{
+			smallestAABBTransformed = Vector3::GetSmallestComponents(corner, smallestAABBTransformed);
+			largestAABBTransformed = Vector3::GetLargestComponents(corner, largestAABBTransformed);
+		}
+	}
+
+	std::shared_ptr<TriangleMeshGeometry> pGeometry;
 
 	Matrix
 		translator,
 		rotor,
 		scalar,
-		finalTransform;
+		finalTransform,
+		inverseTransform;
 };
 
 struct Light
@@ -294,15 +693,101 @@ public:
 		max{ FLT_MAX };
 };
 
+//	All that traversal records about the closest hit so far, the surface attributes only get built once for the final hit
 struct HitRecord
 {
+public:
+	float t{ FLT_MAX };
+
+	//	Barycentric coordinates of triangle hits
+	float
+		u{},
+		v{};
+
+	//	The object gets assigned by the scene, the primitive is the triangle of a mesh or the slot of a sphere or plane
+	int
+		objectIndex{},
+		primitiveIndex{};
+
+	bool didHit{};
+};
+
+struct SurfacePoint
+{
 public:
 	Vector3
 		origin,
 		normal;
 
-	float t{ FLT_MAX };
-	bool didHit{};
-
 	unsigned char materialIndex;
+};
+
+//	The rays of a block of pixels with every component in its own array, so a node gets slab tested against four rays per SSE instruction.
+//	activeMask holds a bit for every lane that carries a ray
+struct RayPacket
+{
+public:
+	static constexpr int
+		WIDTH{ 4 },
+		HEIGHT{ 4 },
+		SIZE{ WIDTH * HEIGHT };
+
+	inline void SetRay(int lane, const Ray& ray)
+	{
+		aOriginX[lane] = ray.origin.x;
+		aOriginY[lane] = ray.origin.y;
+		aOriginZ[lane] = ray.origin.z;
+
+		aDirectionX[lane] = ray.direction.x;
+		aDirectionY[lane] = ray.direction.y;
+		aDirectionZ[lane] = ray.direction.z;
+
+		aInverseDirectionX[lane] = 1.0f / ray.direction.x;
+		aInverseDirectionY[lane] = 1.0f / ray.direction.y;
+		aInverseDirectionZ[lane] = 1.0f / ray.direction.z;
+
+		aMin[lane] = ray.min;
+		aMax[lane] = ray.max;
+
+		activeMask |= 1 << lane;
+	}
+
+#ifdef SIMD_MATH
+	//	Sets the eight lanes starting at firstLane to rays from origin, laneMask selects the lanes that become active
+	inline void SetRays(int firstLane, const Vector3& origin, const Vector3x8& directions, int laneMask)
+	{
+		Vector3x8::Broadcast(origin).Store(aOriginX + firstLane, aOriginY + firstLane, aOriginZ + firstLane);
+		directions.Store(aDirectionX + firstLane, aDirectionY + firstLane, aDirectionZ + firstLane);
+		directions.GetReciprocal().Store(aInverseDirectionX + firstLane, aInverseDirectionY + firstLane, aInverseDirectionZ + firstLane);
+
+		_mm256_storeu_ps(aMin + firstLane, _mm256_set1_ps(RAY_EPSILON));
+		_mm256_storeu_ps(aMax + firstLane, _mm256_set1_ps(FLT_MAX));
+
+		activeMask |= laneMask << firstLane;
+	}
+#endif
+
+	inline Ray GetRay(int lane) const
+	{
+		return Ray(
+			Vector3(aOriginX[lane], aOriginY[lane], aOriginZ[lane]),
+			Vector3(aDirectionX[lane], aDirectionY[lane], aDirectionZ[lane]),
+			aMin[lane],
+			aMax[lane]);
+	}
+
+	alignas(16) float
+		aOriginX[SIZE],
+		aOriginY[SIZE],
+		aOriginZ[SIZE],
+		aDirectionX[SIZE],
+		aDirectionY[SIZE],
+		aDirectionZ[SIZE],
+		aInverseDirectionX[SIZE],
+		aInverseDirectionY[SIZE],
+		aInverseDirectionZ[SIZE],
+		aMin[SIZE],
+		aMax[SIZE];
+
+	int activeMask{};
 };
\ No newline at end of file
@@ -0,0 +1,444 @@
+#pragma once
+
+#include <cstdint>
+#include <type_traits>
+#include <immintrin.h>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#endif
+
+//	The widest registers the kernels may use, picked once at startup from CPUID so one binary runs on every CPU of the fleet.
+//	The baseline kernels only need SSE2
+enum class InstructionSet
+{
+	SSE,
+	AVX2,
+	AVX512
+};
+
+//	Widest register width of any instruction set, in floats
+static constexpr int MAX_LANE_WIDTH{ 16 };
+
+inline void GetCPUID(int leaf, int subleaf, int aRegisters[4])
+{
+#ifdef _MSC_VER
+	__cpuidex(aRegisters, leaf, subleaf);
+#else
+	unsigned int eax, ebx, ecx, edx;
+	__cpuid_count(leaf, subleaf, eax, ebx, ecx, edx);
+	aRegisters[0] = static_cast<int>(eax);
+	aRegisters[1] = static_cast<int>(ebx);
+	aRegisters[2] = static_cast<int>(ecx);
+	aRegisters[3] = static_cast<int>(edx);
+#endif
+}
+
+//	The register states the operating system saves on context switches, from XCR0
+inline uint64_t GetEnabledRegisterStates()
+{
+#ifdef _MSC_VER
+	return _xgetbv(0);
+#else
+	unsigned int eax, edx;
+	__asm__("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+	return static_cast<uint64_t>(edx) << 32 | eax;
+#endif
+}
+
+inline InstructionSet DetectInstructionSet()
+{
+	int aRegisters[4];
+	GetCPUID(0, 0, aRegisters);
+	const int maxLeaf{ aRegisters[0] };
+
+	GetCPUID(1, 0, aRegisters);
+	const int leaf1ECX{ aRegisters[2] };
+
+	const bool
+		hasXSave{ bool(leaf1ECX & 1 << 27) },
+		hasAVX{ bool(leaf1ECX & 1 << 28) },
+		hasFMA{ bool(leaf1ECX & 1 << 12) };
+
+	if (maxLeaf < 7 || !hasXSave || !hasAVX || !hasFMA)
+		return InstructionSet::SSE;
+
+	GetCPUID(7, 0, aRegisters);
+	const int leaf7EBX{ aRegisters[1] };
+
+	static constexpr uint64_t
+		AVX_STATES{ 0x6 },
+		AVX512_STATES{ 0xE6 };
+
+	const uint64_t enabledStates{ GetEnabledRegisterStates() };
+	if (!(leaf7EBX & 1 << 5) || (enabledStates & AVX_STATES) != AVX_STATES)
+		return InstructionSet::SSE;
+
+	if (!(leaf7EBX & 1 << 16) || (enabledStates & AVX512_STATES) != AVX512_STATES)
+		return InstructionSet::AVX2;
+
+	return InstructionSet::AVX512;
+}
+
+inline InstructionSet GetInstructionSet()
+{
+	static const InstructionSet instructionSet{ DetectInstructionSet() };
+	return instructionSet;
+}
+
+inline const char* GetInstructionSetName(InstructionSet instructionSet)
+{
+	switch (instructionSet)
+	{
+	case InstructionSet::SSE:
+		return "SSE";
+
+	case InstructionSet::AVX2:
+		return "AVX2";
+
+	case InstructionSet::AVX512:
+		return "AVX-512";
+	}
+
+	return "UNKNOWN";
+}
+
+//	Calls function with the instruction set as a std::integral_constant, so kernels get instantiated per register width
+template<typename Function>
+inline auto DispatchInstructionSet(InstructionSet instructionSet, Function function)
+{
+	switch (instructionSet)
+	{
+	case InstructionSet::AVX2:
+		return function(std::integral_constant<InstructionSet, InstructionSet::AVX2>());
+
+	case InstructionSet::AVX512:
+		return function(std::integral_constant<InstructionSet, InstructionSet::AVX512>());
+
+	default:
+		return function(std::integral_constant<InstructionSet, InstructionSet::SSE>());
+	}
+}
+
+//	The operations the lane-wide kernels need, so they can be written once for every register width
+template<InstructionSet INSTRUCTION_SET>
+struct FloatLanes;
+
+template<>
+struct FloatLanes<InstructionSet::SSE>
+{
+public:
+	using Type = __m128;
+	using IntegerType = __m128i;
+	static constexpr int WIDTH{ 4 };
+
+	static inline Type Set(float value)
+	{
+		return _mm_set1_ps(value);
+	}
+
+	static inline Type Load(const float* pValues)
+	{
+		return _mm_loadu_ps(pValues);
+	}
+
+	static inline void Store(float* pValues, Type values)
+	{
+		_mm_storeu_ps(pValues, values);
+	}
+
+	static inline Type Add(Type values1, Type values2)
+	{
+		return _mm_add_ps(values1, values2);
+	}
+
+	static inline Type Subtract(Type values1, Type values2)
+	{
+		return _mm_sub_ps(values1, values2);
+	}
+
+	static inline Type Multiply(Type values1, Type values2)
+	{
+		return _mm_mul_ps(values1, values2);
+	}
+
+	static inline Type Divide(Type values1, Type values2)
+	{
+		return _mm_div_ps(values1, values2);
+	}
+
+	static inline Type GetAbsolute(Type values)
+	{
+		return _mm_andnot_ps(_mm_set1_ps(-0.0f), values);
+	}
+
+	static inline Type GetSquareRoot(Type values)
+	{
+		return _mm_sqrt_ps(values);
+	}
+
+	//	Per lane values1 < values2 ? lessValues : otherValues
+	static inline Type SelectLess(Type values1, Type values2, Type lessValues, Type otherValues)
+	{
+		const Type isLess{ _mm_cmplt_ps(values1, values2) };
+		return _mm_or_ps(_mm_and_ps(isLess, lessValues), _mm_andnot_ps(isLess, otherValues));
+	}
+
+	static inline int GetLessMask(Type values1, Type values2)
+	{
+		return _mm_movemask_ps(_mm_cmplt_ps(values1, values2));
+	}
+
+	static inline int GetLessEqualMask(Type values1, Type values2)
+	{
+		return _mm_movemask_ps(_mm_cmple_ps(values1, values2));
+	}
+
+	static inline int GetGreaterMask(Type values1, Type values2)
+	{
+		return _mm_movemask_ps(_mm_cmpgt_ps(values1, values2));
+	}
+
+	static inline int GetGreaterEqualMask(Type values1, Type values2)
+	{
+		return _mm_movemask_ps(_mm_cmpge_ps(values1, values2));
+	}
+
+	static inline IntegerType SetIntegers(int value)
+	{
+		return _mm_set1_epi32(value);
+	}
+
+	//	Rounds toward zero, like a cast
+	static inline IntegerType ConvertToIntegers(Type values)
+	{
+		return _mm_cvttps_epi32(values);
+	}
+
+	static inline IntegerType ShiftLeft(IntegerType values, int amount)
+	{
+		return _mm_sll_epi32(values, _mm_cvtsi32_si128(amount));
+	}
+
+	static inline IntegerType Or(IntegerType values1, IntegerType values2)
+	{
+		return _mm_or_si128(values1, values2);
+	}
+
+	static inline void StoreIntegers(uint32_t* pValues, IntegerType values)
+	{
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(pValues), values);
+	}
+};
+
+template<>
+struct FloatLanes<InstructionSet::AVX2>
+{
+public:
+	using Type = __m256;
+	using IntegerType = __m256i;
+	static constexpr int WIDTH{ 8 };
+
+	static inline Type Set(float value)
+	{
+		return _mm256_set1_ps(value);
+	}
+
+	static inline Type Load(const float* pValues)
+	{
+		return _mm256_loadu_ps(pValues);
+	}
+
+	static inline void Store(float* pValues, Type values)
+	{
+		_mm256_storeu_ps(pValues, values);
+	}
+
+	static inline Type Add(Type values1, Type values2)
+	{
+		return _mm256_add_ps(values1, values2);
+	}
+
+	static inline Type Subtract(Type values1, Type values2)
+	{
+		return _mm256_sub_ps(values1, values2);
+	}
+
+	static inline Type Multiply(Type values1, Type values2)
+	{
+		return _mm256_mul_ps(values1, values2);
+	}
+
+	static inline Type Divide(Type values1, Type values2)
+	{
+		return _mm256_div_ps(values1, values2);
+	}
+
+	static inline Type GetAbsolute(Type values)
+	{
+		return _mm256_andnot_ps(_mm256_set1_ps(-0.0f), values);
+	}
+
+	static inline Type GetSquareRoot(Type values)
+	{
+		return _mm256_sqrt_ps(values);
+	}
+
+	static inline Type SelectLess(Type values1, Type values2, Type lessValues, Type otherValues)
+	{
+		return _mm256_blendv_ps(otherValues, lessValues, _mm256_cmp_ps(values1, values2, _CMP_LT_OQ));
+	}
+
+	static inline int GetLessMask(Type values1, Type values2)
+	{
+		return _mm256_movemask_ps(_mm256_cmp_ps(values1, values2, _CMP_LT_OQ));
+	}
+
+	static inline int GetLessEqualMask(Type values1, Type values2)
+	{
+		return _mm256_movemask_ps(_mm256_cmp_ps(values1, values2, _CMP_LE_OQ));
+	}
+
+	static inline int GetGreaterMask(Type values1, Type values2)
+	{
+		return _mm256_movemask_ps(_mm256_cmp_ps(values1, values2, _CMP_GT_OQ));
+	}
+
+	static inline int GetGreaterEqualMask(Type values1, Type values2)
+	{
+		return _mm256_movemask_ps(_mm256_cmp_ps(values1, values2, _CMP_GE_OQ));
+	}
+
+	static inline IntegerType SetIntegers(int value)
+	{
+		return _mm256_set1_epi32(value);
+	}
+
+	//	Rounds toward zero, like a cast
+	static inline IntegerType ConvertToIntegers(Type values)
+	{
+		return _mm256_cvttps_epi32(values);
+	}
+
+	static inline IntegerType ShiftLeft(IntegerType values, int amount)
+	{
+		return _mm256_sll_epi32(values, _mm_cvtsi32_si128(amount));
+	}
+
+	static inline IntegerType Or(IntegerType values1, IntegerType values2)
+	{
+		return _mm256_or_si256(values1, values2);
+	}
+
+	static inline void StoreIntegers(uint32_t* pValues, IntegerType values)
+	{
+		_mm256_storeu_si256(reinterpret_cast<__m256i*>(pValues), values);
+	}
+};
+
+template<>
+struct FloatLanes<InstructionSet::AVX512>
+{
+public:
+	using Type = __m512;
+	using IntegerType = __m512i;
+	static constexpr int WIDTH{ 16 };
+
+	static inline Type Set(float value)
+	{
+		return _mm512_set1_ps(value);
+	}
+
+	static inline Type Load(const float* pValues)
+	{
+		return _mm512_loadu_ps(pValues);
+	}
+
+	static inline void Store(float* pValues, Type values)
+	{
+		_mm512_storeu_ps(pValues, values);
+	}
+
+	static inline Type Add(Type values1, Type values2)
+	{
+		return _mm512_add_ps(values1, values2);
+	}
+
+	static inline Type Subtract(Type values1, Type values2)
+	{
+		return _mm512_sub_ps(values1, values2);
+	}
+
+	static inline Type Multiply(Type values1, Type values2)
+	{
+		return _mm512_mul_ps(values1, values2);
+	}
+
+	static inline Type Divide(Type values1, Type values2)
+	{
+		return _mm512_div_ps(values1, values2);
+	}
+
+	static inline Type GetAbsolute(Type values)
+	{
+		return _mm512_abs_ps(values);
+	}
+
+	static inline Type GetSquareRoot(Type values)
+	{
+		return _mm512_sqrt_ps(values);
+	}
+
+	static inline Type SelectLess(Type values1, Type values2, Type lessValues, Type otherValues)
+	{
+		return _mm512_mask_blend_ps(_mm512_cmp_ps_mask(values1, values2, _CMP_LT_OQ), otherValues, lessValues);
+	}
+
+	static inline int GetLessMask(Type values1, Type values2)
+	{
+		return _mm512_cmp_ps_mask(values1, values2, _CMP_LT_OQ);
+	}
+
+	static inline int GetLessEqualMask(Type values1, Type values2)
+	{
+		return _mm512_cmp_ps_mask(values1, values2, _CMP_LE_OQ);
+	}
+
+	static inline int GetGreaterMask(Type values1, Type values2)
+	{
+		return _mm512_cmp_ps_mask(values1, values2, _CMP_GT_OQ);
+	}
+
+	static inline int GetGreaterEqualMask(Type values1, Type values2)
+	{
+		return _mm512_cmp_ps_mask(values1, values2, _CMP_GE_OQ);
+	}
+
+	static inline IntegerType SetIntegers(int value)
+	{
+		return _mm512_set1_epi32(value);
+	}
+
+	//	Rounds toward zero, like a cast
+	static inline IntegerType ConvertToIntegers(Type values)
+	{
+		return _mm512_cvttps_epi32(values);
+	}
+
+	static inline IntegerType ShiftLeft(IntegerType values, int amount)
+	{
+		return _mm512_sll_epi32(values, _mm_cvtsi32_si128(amount));
+	}
+
+	static inline IntegerType Or(IntegerType values1, IntegerType values2)
+	{
+		return _mm512_or_si512(values1, values2);
+	}
+
+	static inline void StoreIntegers(uint32_t* pValues, IntegerType values)
+	{
+		_mm512_storeu_si512(pValues, values);
+	}
+};
\ No newline at end of file
@@ -18,7 +18,7 @@ public:
 	Material& operator=(const Material&) = delete;
 	Material& operator=(Material&&) noexcept = delete;
 
-	virtual ColorRGB Shade(const HitRecord& hitRecord, const Vector3& lightDirection, const Vector3& viewDirection) const = 0;
+	virtual ColorRGB Shade(const SurfacePoint& surfacePoint, const Vector3& lightDirection, const Vector3& viewDirection) const = 0;
 
 	const float m_Roughness;
 };
@@ -40,7 +40,7 @@ public:
 	SolidColorMaterial& operator=(const SolidColorMaterial&) = delete;
 	SolidColorMaterial& operator=(SolidColorMaterial&&) noexcept = delete;
 
-	virtual ColorRGB Shade([[maybe_unused]] const HitRecord& hitRecord = HitRecord(), [[maybe_unused]] const Vector3& lightDirection = Vector3(), [[maybe_unused]] const Vector3& viewDirection = Vector3()) const override
+	virtual ColorRGB Shade([[maybe_unused]] const SurfacePoint& surfacePoint = SurfacePoint(), [[maybe_unused]] const Vector3& lightDirection = Vector3(), [[maybe_unused]] const Vector3& viewDirection = Vector3()) const override
 	{
 		return m_Color;
 	}
@@ -67,7 +67,7 @@ public:
 	LambertMaterial& operator=(const LambertMaterial&) = delete;
 	LambertMaterial& operator=(LambertMaterial&&) noexcept = delete;
 
-	virtual ColorRGB Shade([[maybe_unused]] const HitRecord& hitRecord = HitRecord(), [[maybe_unused]] const Vector3& lightDirection = Vector3(), [[maybe_unused]] const Vector3& viewDirection = Vector3()) const override
+	virtual ColorRGB Shade([[maybe_unused]] const SurfacePoint& surfacePoint = SurfacePoint(), [[maybe_unused]] const Vector3& lightDirection = Vector3(), [[maybe_unused]] const Vector3& viewDirection = Vector3()) const override
 	{
 		return Lambert(m_DiffuseReflectance, m_DiffuseColor);
 	}
@@ -95,11 +95,11 @@ public:
 	LambertPhongMaterial& operator=(const LambertPhongMaterial&) = delete;
 	LambertPhongMaterial& operator=(LambertPhongMaterial&&) noexcept = delete;
 
-	virtual ColorRGB Shade(const HitRecord& hitRecord, const Vector3& lightDirection, const Vector3& viewDirection) const override
+	virtual ColorRGB Shade(const SurfacePoint& surfacePoint, const Vector3& lightDirection, const Vector3& viewDirection) const override
 	{
 		return
 			Lambert(m_DiffuseReflectance, m_DiffuseColor) +
-			Phong(m_SpecularReflectance, m_PhongExponent, lightDirection, viewDirection, hitRecord.normal);
+			Phong(m_SpecularReflectance, m_PhongExponent, lightDirection, viewDirection, surfacePoint.normal);
 	}
 
 private:
@@ -126,7 +126,7 @@ public:
 	CookTorrenceMaterial& operator=(const CookTorrenceMaterial&) = delete;
 	CookTorrenceMaterial& operator=(CookTorrenceMaterial&&) noexcept = delete;
 
-	virtual ColorRGB Shade(const HitRecord& hitRecord, const Vector3& lightDirection, const Vector3& viewDirection) const override
+	virtual ColorRGB Shade(const SurfacePoint& surfacePoint, const Vector3& lightDirection, const Vector3& viewDirection) const override
 	{
 		const Vector3
 			negativeViewDirection{ -viewDirection },
@@ -137,11 +137,11 @@ public:
 			f{ FresnelFunctionSchlick(h, negativeViewDirection, f0) };
 
 		const float
-			d{ NormalDistributionGGX(hitRecord.normal, h, m_Roughness) },
-			g{ GeometryFunctionSmith(hitRecord.normal, negativeViewDirection, lightDirection, m_Roughness) };
+			d{ NormalDistributionGGX(surfacePoint.normal, h, m_Roughness) },
+			g{ GeometryFunctionSmith(surfacePoint.normal, negativeViewDirection, lightDirection, m_Roughness) };
 
 		const ColorRGB
-			specular{ (f * d * g) / (4.0f * Vector3::Dot(negativeViewDirection, hitRecord.normal) * Vector3::Dot(lightDirection, hitRecord.normal)) },
+			specular{ (f * d * g) / (4.0f * Vector3::Dot(negativeViewDirection, surfacePoint.normal) * Vector3::Dot(lightDirection, surfacePoint.normal)) },
 			kd{ m_Metalness == 0.0f ? (WHITE - f) : BLACK },
 			diffuse{ Lambert(kd, m_Albedo) };
 
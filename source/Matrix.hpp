@@ -1,7 +1,13 @@
 #pragma once
 
+#include <algorithm>
+#include <execution>
+#include <vector>
+
+#include "InstructionSet.hpp"
 #include "Vector4.hpp"
 #include "Vector3.hpp"
+#include "Vector3x8.hpp"
 
 class Matrix
 {
@@ -15,12 +21,19 @@ public:
 
 	inline Vector3 TransformVector(float x, float y, float z) const
 	{
+#ifdef SIMD_MATH
+		return GetVector3(_mm_add_ps(_mm_add_ps(
+			_mm_mul_ps(m_Data[0].Load(), _mm_set1_ps(x)),
+			_mm_mul_ps(m_Data[1].Load(), _mm_set1_ps(y))),
+			_mm_mul_ps(m_Data[2].Load(), _mm_set1_ps(z))));
+#else
 		return Vector3
 		(
 			m_Data[0].x * x + m_Data[1].x * y + m_Data[2].x * z,
 			m_Data[0].y * x + m_Data[1].y * y + m_Data[2].y * z,
 			m_Data[0].z * x + m_Data[1].z * y + m_Data[2].z * z
 		);
+#endif
 	}
 
 	inline Vector3 TransformVector(const Vector3& vector) const
@@ -30,12 +43,20 @@ public:
 
 	inline Vector3 TransformPoint(float x, float y, float z) const
 	{
+#ifdef SIMD_MATH
+		return GetVector3(_mm_add_ps(_mm_add_ps(_mm_add_ps(
+			_mm_mul_ps(m_Data[0].Load(), _mm_set1_ps(x)),
+			_mm_mul_ps(m_Data[1].Load(), _mm_set1_ps(y))),
+			_mm_mul_ps(m_Data[2].Load(), _mm_set1_ps(z))),
+			m_Data[3].Load()));
+#else
 		return Vector3
 		(
 			m_Data[0].x * x + m_Data[1].x * y + m_Data[2].x * z + m_Data[3].x,
 			m_Data[0].y * x + m_Data[1].y * y + m_Data[2].y * z + m_Data[3].y,
 			m_Data[0].z * x + m_Data[1].z * y + m_Data[2].z * z + m_Data[3].z
 		);
+#endif
 	}
 
 	inline Vector3 TransformPoint(const Vector3& point) const
@@ -43,14 +64,106 @@ public:
 		return TransformPoint(point.x, point.y, point.z);
 	}
 
+#ifdef SIMD_MATH
+	inline Vector3x8 TransformVector(const Vector3x8& vector) const
+	{
+		const auto transformComponent
+		{
+			[&vector](float xAxisComponent, float yAxisComponent, float zAxisComponent)
+			{
+				return _mm256_add_ps(_mm256_add_ps(
+					_mm256_mul_ps(_mm256_set1_ps(xAxisComponent), vector.x),
+					_mm256_mul_ps(_mm256_set1_ps(yAxisComponent), vector.y)),
+					_mm256_mul_ps(_mm256_set1_ps(zAxisComponent), vector.z));
+			}
+		};
+
+		return Vector3x8
+		(
+			transformComponent(m_Data[0].x, m_Data[1].x, m_Data[2].x),
+			transformComponent(m_Data[0].y, m_Data[1].y, m_Data[2].y),
+			transformComponent(m_Data[0].z, m_Data[1].z, m_Data[2].z)
+		);
+	}
+
+	inline Vector3x8 TransformPoint(const Vector3x8& point) const
+	{
+		return TransformVector(point) + Vector3x8::Broadcast(Vector3(m_Data[3].x, m_Data[3].y, m_Data[3].z));
+	}
+#endif
+
+	//	Transforms by the transposed upper 3x3, called on an inverse matrix this transforms normals
+	inline Vector3 TransformVectorTransposed(const Vector3& vector) const
+	{
+		return Vector3
+		(
+			m_Data[0].x * vector.x + m_Data[0].y * vector.y + m_Data[0].z * vector.z,
+			m_Data[1].x * vector.x + m_Data[1].y * vector.y + m_Data[1].z * vector.z,
+			m_Data[2].x * vector.x + m_Data[2].y * vector.y + m_Data[2].z * vector.z
+		);
+	}
+
+	//	The batch transforms take whole arrays, pInput and pOutput may point to the same array
+	inline void TransformPoints(const Vector3* pInput, Vector3* pOutput, int amount) const
+	{
+		TransformBatch<true, false>(pInput, pOutput, amount);
+	}
+
+	inline void TransformVectors(const Vector3* pInput, Vector3* pOutput, int amount) const
+	{
+		TransformBatch<false, false>(pInput, pOutput, amount);
+	}
+
+	//	Transforms normals by the inverse transpose of this matrix and renormalizes them, so scaled transforms keep them perpendicular
+	inline void TransformNormals(const Vector3* pInput, Vector3* pOutput, int amount) const
+	{
+		GetAffineInverse().GetTransposed().TransformBatch<false, true>(pInput, pOutput, amount);
+	}
+
+	//	Only valid for affine matrices, which every Create function returns
+	inline Matrix GetAffineInverse() const
+	{
+		const Vector3
+			xAxis{ m_Data[0].x, m_Data[0].y, m_Data[0].z },
+			yAxis{ m_Data[1].x, m_Data[1].y, m_Data[1].z },
+			zAxis{ m_Data[2].x, m_Data[2].y, m_Data[2].z },
+			yCrossZ{ Vector3::Cross(yAxis, zAxis) },
+			zCrossX{ Vector3::Cross(zAxis, xAxis) },
+			xCrossY{ Vector3::Cross(xAxis, yAxis) };
+
+		const float inverseDeterminant{ 1.0f / Vector3::Dot(xAxis, yCrossZ) };
+
+		Matrix result
+		(
+			Vector4(yCrossZ.x, zCrossX.x, xCrossY.x, 0.0f) * inverseDeterminant,
+			Vector4(yCrossZ.y, zCrossX.y, xCrossY.y, 0.0f) * inverseDeterminant,
+			Vector4(yCrossZ.z, zCrossX.z, xCrossY.z, 0.0f) * inverseDeterminant,
+			VECTOR4_UNIT_T
+		);
+
+		result[3] = (-result.TransformVector(m_Data[3].x, m_Data[3].y, m_Data[3].z)).GetPoint4();
+		return result;
+	}
+
 	inline Matrix GetTransposed() const
 	{
+#ifdef SIMD_MATH
+		__m128
+			row0{ m_Data[0].Load() },
+			row1{ m_Data[1].Load() },
+			row2{ m_Data[2].Load() },
+			row3{ m_Data[3].Load() };
+
+		_MM_TRANSPOSE4_PS(row0, row1, row2, row3);
+		return Matrix(Vector4::Store(row0), Vector4::Store(row1), Vector4::Store(row2), Vector4::Store(row3));
+#else
 		Matrix result;
 		for (int currentRow{}; currentRow < 4; ++currentRow)
 			for (int currentColumn{}; currentColumn < 4; ++currentColumn)
 				result[currentRow][currentColumn] = m_Data[currentColumn][currentRow];;
 
 		return result;
+#endif
 	}
 
 	inline const Matrix& Transpose()
@@ -151,6 +264,18 @@ public:
 
 	inline Matrix operator*(const Matrix& matrix) const
 	{
+#ifdef SIMD_MATH
+		//	Every row of the result is the rows of matrix weighted by the components of the matching row
+		Matrix result;
+		for (int currentRow{}; currentRow < 4; ++currentRow)
+			result[currentRow] = Vector4::Store(_mm_add_ps(_mm_add_ps(_mm_add_ps(
+				_mm_mul_ps(_mm_set1_ps(m_Data[currentRow].x), matrix[0].Load()),
+				_mm_mul_ps(_mm_set1_ps(m_Data[currentRow].y), matrix[1].Load())),
+				_mm_mul_ps(_mm_set1_ps(m_Data[currentRow].z), matrix[2].Load())),
+				_mm_mul_ps(_mm_set1_ps(m_Data[currentRow].w), matrix[3].Load())));
+
+		return result;
+#else
 		Matrix result;
 		const Matrix transposedMatrix{ matrix.GetTransposed() };
 
@@ -159,6 +284,7 @@ public:
 				result[currentRow][currentColumn] = Vector4::Dot(m_Data[currentRow], transposedMatrix[currentColumn]);
 
 		return result;
+#endif
 	}
 
 	inline const Matrix& operator*=(const Matrix& matrix)
@@ -187,6 +313,75 @@ public:
 	}
 
 private:
+	static constexpr int PARALLEL_TRANSFORM_CHUNK_SIZE{ 16384 };
+
+	//	Large arrays get split into chunks that are transformed in parallel
+	template<bool IS_POINT, bool IS_NORMALIZING>
+	inline void TransformBatch(const Vector3* pInput, Vector3* pOutput, int amount) const
+	{
+		if (amount <= PARALLEL_TRANSFORM_CHUNK_SIZE)
+		{
+			TransformRange<IS_POINT, IS_NORMALIZING>(pInput, pOutput, amount);
+			return;
+		}
+
+		struct Chunk
+		{
+			int
+				first,
+				amount;
+		};
+
+		std::vector<Chunk> vChunks{};
+		for (int first{}; first < amount; first += PARALLEL_TRANSFORM_CHUNK_SIZE)
+			vChunks.push_back(Chunk(first, std::min(PARALLEL_TRANSFORM_CHUNK_SIZE, amount - first)));
+
+		std::for_each(std::execution::par, vChunks.begin(), vChunks.end(),
+			[this, pInput, pOutput](const Chunk& chunk)
+			{
+				TransformRange<IS_POINT, IS_NORMALIZING>(pInput + chunk.first, pOutput + chunk.first, chunk.amount);
+			});
+	}
+
+	template<bool IS_POINT, bool IS_NORMALIZING>
+	inline void TransformRange(const Vector3* pInput, Vector3* pOutput, int amount) const
+	{
+		int index{};
+
+#ifdef SIMD_MATH
+		if (GetInstructionSet() != InstructionSet::SSE)
+			for (; index + Vector3x8::WIDTH <= amount; index += Vector3x8::WIDTH)
+			{
+				const Vector3x8 input{ Vector3x8::LoadInterleaved(pInput + index) };
+				Vector3x8 output{ IS_POINT ? TransformPoint(input) : TransformVector(input) };
+
+				if constexpr (IS_NORMALIZING)
+					output.Normalize();
+
+				output.StoreInterleaved(pOutput + index);
+			}
+#endif
+
+		for (; index < amount; ++index)
+		{
+			Vector3 output{ IS_POINT ? TransformPoint(pInput[index]) : TransformVector(pInput[index]) };
+
+			if constexpr (IS_NORMALIZING)
+				output.Normalize();
+
+			pOutput[index] = output;
+		}
+	}
+
+#ifdef SIMD_MATH
+	static inline Vector3 GetVector3(__m128 components)
+	{
+		alignas(16) float aComponents[4];
+		_mm_store_ps(aComponents, components);
+		return Vector3(aComponents[0], aComponents[1], aComponents[2]);
+	}
+#endif
+
 	Vector4 m_Data[4];
 };
 
@@ -1,45 +1,616 @@
 #include "Renderer.h"
 
-#include <execution>
+#include <cmath>
 #include <iostream>
+#include <numeric>
+#include <thread>
 
 #include "Scene.h"
 #include "Materials.hpp"
 #include "Utilities.hpp"
+#include "ColorRGBx8.hpp"
 
-Renderer::Renderer(SDL_Window* const pWindow, const Scene* const pScene) :
+Renderer::Renderer(SDL_Window* const pWindow, const Scene* const pScene, int threadAmount, int tileSize) :
 	m_pWindow{ pWindow },
 	m_pBuffer{ SDL_GetWindowSurface(pWindow) },
-	m_pBufferPixels{ static_cast<uint32_t*>(m_pBuffer->pixels) },
+	m_pBufferPixels{},
+
+	m_vRenderPixels{},
+	m_vPresentPixels{},
 
 	m_pScene{ pScene },
 
+	m_pCameraLatch{},
+
+	m_RenderInputTime{ SDL_GetPerformanceCounter() },
+	m_PresentInputTime{ m_RenderInputTime },
+
+	m_InputLatency{},
+
+	m_InstructionSet{ GetInstructionSet() },
+
 	m_LightingMode{ LightingMode::combined },
 
 	m_CastShadows{ true },
+	m_IsReflecting{ false },
 
-	m_PixelsY{}
+	m_ThreadPool{ threadAmount },
+	//	Rounded up to whole ray packets
+	m_TileSize{ (std::max(tileSize, 1) + RayPacket::WIDTH - 1) / RayPacket::WIDTH * RayPacket::WIDTH },
+	m_TileAmountX{},
+	m_vTiles{},
 
-#ifdef REFLECT
-	,m_ReflectionBounceAmount{ 5 },
+	m_ReflectionBounceAmount{ 5 },
+	m_SamplerType{ SamplerType::sobol },
 
 	m_vAccumulatedReflectionData{},
-	m_FrameIndex{ 1 }
-#endif
+	m_vTileFrameIndices{},
+
+	m_IsWavefront{ false },
+	m_PathQueue{},
+	m_BouncingPathQueue{},
+	m_vSortedPathIndices{},
+	m_vMaterialOffsets{},
+	m_vChunkMaterialOffsets{},
+	m_vChunkBouncingPathOffsets{},
+	m_vShadowRays{},
+	m_vAreShadowRaysOccluded{},
+	m_vFrameColors{},
+
+	m_IsSkippingUnchangedFrames{ true },
+	m_AreSettingsChanged{ true },
+	m_IsSkippingFrame{},
+
+	m_RenderedCameraToWorld{},
+	m_RenderedFieldOfViewValue{},
+
+	m_vRenderedObjects{},
+	m_vObjects{},
+	m_vRenderedSpheres{},
+	m_vRenderedPlanes{},
+	m_vRenderedLights{},
+	m_RenderedMaterialAmount{},
+
+	m_IsPreviewing{ true },
+	m_IsReusingSamples{},
+	m_PreviewScale{ 1 },
+	m_ImageScale{ 1 },
+	m_TargetFrameTime{ DEFAULT_TARGET_FRAME_TIME },
+	m_TracedPixelTime{},
+	m_vPreviewColors{},
+	m_vPreviewDepths{},
+
+	m_vAreTilesDirty{},
+	m_vDirtyTileIndices{},
+	m_IsFullFrame{},
+
+	m_vPresentRects{},
+	m_IsPresentingFullFrame{},
+
+	m_RenderFuture{}
 {
 	SDL_GetWindowSize(pWindow, &m_Width, &m_Height);
 
-	for (float pixelY{ 0.5f }; pixelY < m_Height; ++pixelY)
-		m_PixelsY.push_back(pixelY);
+	m_vRenderPixels.resize(m_Width * m_Height);
+	m_vPresentPixels.resize(m_Width * m_Height);
+	m_pBufferPixels = m_vRenderPixels.data();
+
+	//	Spreads the lowest 16 bits so a zero bit follows each of them
+	const auto expandBits
+	{
+		[](unsigned int value)
+		{
+			value = (value | (value << 8)) & 0x00FF00FFu;
+			value = (value | (value << 4)) & 0x0F0F0F0Fu;
+			value = (value | (value << 2)) & 0x33333333u;
+			value = (value | (value << 1)) & 0x55555555u;
+			return value;
+		}
+	};
+
+	//	The tiles get handed out along a Morton curve, so the tiles every worker starts with and steals stay close together on screen
+	for (int tileY{}; tileY < m_Height; tileY += m_TileSize)
+		for (int tileX{}; tileX < m_Width; tileX += m_TileSize)
+			m_vTiles.push_back(Tile(tileX, tileY));
+
+	std::sort(m_vTiles.begin(), m_vTiles.end(),
+		[this, &expandBits](const Tile& tile1, const Tile& tile2)
+		{
+			return
+				(expandBits(tile1.x / m_TileSize) | expandBits(tile1.y / m_TileSize) << 1) <
+				(expandBits(tile2.x / m_TileSize) | expandBits(tile2.y / m_TileSize) << 1);
+		});
+
+	m_TileAmountX = (m_Width + m_TileSize - 1) / m_TileSize;
+	m_vTileFrameIndices.resize(m_vTiles.size(), 1);
+	m_vAreTilesDirty.resize(m_vTiles.size());
 
-#ifdef REFLECT
 	m_vAccumulatedReflectionData.resize(m_Width * m_Height);
-#endif
+	m_vFrameColors.resize(m_Width * m_Height);
+	m_vPreviewColors.resize(m_Width * m_Height);
+	m_vPreviewDepths.resize(m_Width * m_Height);
 }
 
 void Renderer::Render()
 {
-	const Camera& camera{ m_pScene->GetCamera() };
+	BeginRender();
+	EndRender();
+	Present();
+}
+
+void Renderer::BeginRender()
+{
+	m_RenderFuture = m_ThreadPool.RunAsync([this, renderKernel{ GetRenderKernel() }]() { RenderFrame(renderKernel); });
+}
+
+void Renderer::EndRender()
+{
+	m_RenderFuture.get();
+
+	//	The last finished frame stays the one to present
+	if (m_IsSkippingFrame)
+		return;
+
+	//	Previews don't accumulate
+	if (m_IsReflecting && m_PreviewScale == 1 && !m_IsReusingSamples)
+		for (int& frameIndex : m_vTileFrameIndices)
+			++frameIndex;
+
+	m_ImageScale = m_PreviewScale;
+
+	//	The render pixels outside the dirty tiles are older than the present pixels, so only a full frame can be swapped in
+	if (m_IsFullFrame)
+	{
+		m_vRenderPixels.swap(m_vPresentPixels);
+		m_pBufferPixels = m_vRenderPixels.data();
+		m_IsPresentingFullFrame = true;
+	}
+	else
+		for (int tileIndex : m_vDirtyTileIndices)
+		{
+			const SDL_Rect rect{ GetTileRect(m_vTiles[tileIndex]) };
+			for (int pixelY{ rect.y }; pixelY < rect.y + rect.h; ++pixelY)
+				std::copy_n(m_vRenderPixels.begin() + rect.x + pixelY * m_Width, rect.w, m_vPresentPixels.begin() + rect.x + pixelY * m_Width);
+
+			m_vPresentRects.push_back(rect);
+		}
+
+	m_PresentInputTime = m_RenderInputTime;
+}
+
+bool Renderer::Present()
+{
+	uint32_t* const pSurfacePixels{ static_cast<uint32_t*>(m_pBuffer->pixels) };
+	if (m_IsPresentingFullFrame)
+	{
+		std::copy(m_vPresentPixels.begin(), m_vPresentPixels.end(), pSurfacePixels);
+		SDL_UpdateWindowSurface(m_pWindow);
+	}
+	else if (!m_vPresentRects.empty())
+	{
+		for (const SDL_Rect& rect : m_vPresentRects)
+			for (int pixelY{ rect.y }; pixelY < rect.y + rect.h; ++pixelY)
+				std::copy_n(m_vPresentPixels.begin() + rect.x + pixelY * m_Width, rect.w, pSurfacePixels + rect.x + pixelY * m_Width);
+
+		SDL_UpdateWindowSurfaceRects(m_pWindow, m_vPresentRects.data(), static_cast<int>(m_vPresentRects.size()));
+	}
+	else
+		return false;
+
+	m_IsPresentingFullFrame = false;
+	m_vPresentRects.clear();
+
+	m_InputLatency = float(SDL_GetPerformanceCounter() - m_PresentInputTime) / SDL_GetPerformanceFrequency();
+	return true;
+}
+
+bool Renderer::WaitForRender(int timeoutMilliseconds) const
+{
+	if (m_RenderFuture.wait_for(std::chrono::milliseconds(timeoutMilliseconds)) != std::future_status::ready)
+		return false;
+
+	if (m_IsSkippingFrame)
+		std::this_thread::sleep_for(std::chrono::milliseconds(timeoutMilliseconds));
+
+	return true;
+}
+
+void Renderer::RenderFrame(RenderKernel renderKernel)
+{
+	const Camera camera{ LatchCamera() };
+	UpdateDirtyTiles(camera);
+	m_AreSettingsChanged = false;
+
+	m_IsSkippingFrame = m_vDirtyTileIndices.empty();
+	if (!m_IsSkippingFrame)
+		(this->*renderKernel)(camera);
+}
+
+Camera Renderer::LatchCamera()
+{
+	const Camera camera{ m_pCameraLatch ? m_pCameraLatch->Load(m_RenderInputTime) : m_pScene->GetCamera() };
+	if (!m_pCameraLatch)
+		m_RenderInputTime = SDL_GetPerformanceCounter();
+
+	return camera;
+}
+
+void Renderer::UpdateDirtyTiles(const Camera& camera)
+{
+	const auto& vSpheres{ m_pScene->GetSpheres() };
+	const auto& vPlanes{ m_pScene->GetPlanes() };
+	const auto& vLights{ m_pScene->GetLights() };
+	const auto& vpMaterials{ m_pScene->GetMaterials() };
+
+	m_vObjects.clear();
+	for (const Sphere& sphere : vSpheres)
+	{
+		const Vector3 radius{ sphere.radius, sphere.radius, sphere.radius };
+		m_vObjects.push_back(ObjectState(AABB(sphere.origin - radius, sphere.origin + radius), IDENTITY, sphere.materialIndex, Triangle::CullMode::none, 0));
+	}
+
+	for (const TriangleMesh& triangleMesh : m_pScene->GetTriangleMeshes())
+		m_vObjects.push_back(ObjectState
+		(
+			AABB(triangleMesh.smallestAABBTransformed, triangleMesh.largestAABBTransformed),
+			triangleMesh.GetTransform(),
+			triangleMesh.materialIndex,
+			triangleMesh.cullMode,
+			triangleMesh.GetGeometry().fingerprint
+		));
+
+	const bool areLightsUnchanged
+	{
+		std::equal(vLights.begin(), vLights.end(), m_vRenderedLights.begin(), m_vRenderedLights.end(),
+			[](const Light& light1, const Light& light2)
+			{
+				return
+					light1.origin == light2.origin && light1.intensity == light2.intensity &&
+					light1.color.red == light2.color.red && light1.color.green == light2.color.green && light1.color.blue == light2.color.blue;
+			})
+	};
+
+	const bool isCameraMoving{ !(camera.GetCameraToWorld() == m_RenderedCameraToWorld) || camera.GetFieldOfViewValue() != m_RenderedFieldOfViewValue };
+
+	std::fill(m_vAreTilesDirty.begin(), m_vAreTilesDirty.end(), false);
+	m_vDirtyTileIndices.clear();
+	m_IsFullFrame = false;
+
+	if (m_AreSettingsChanged || vPlanes != m_vRenderedPlanes || !areLightsUnchanged || vpMaterials.size() != m_RenderedMaterialAmount ||
+		vSpheres.size() != m_vRenderedSpheres.size() || m_vObjects.size() != m_vRenderedObjects.size() || isCameraMoving)
+		MarkAllTilesDirty();
+	else
+	{
+		const Matrix worldToCamera{ m_RenderedCameraToWorld.GetAffineInverse() };
+		for (int objectIndex{}; objectIndex < m_vObjects.size() && !m_IsFullFrame; ++objectIndex)
+		{
+			const ObjectState
+				& renderedObject{ m_vRenderedObjects[objectIndex] },
+				& object{ m_vObjects[objectIndex] };
+
+			if (objectIndex < vSpheres.size() ? vSpheres[objectIndex] == m_vRenderedSpheres[objectIndex] : object == renderedObject)
+				continue;
+
+			MarkDirtyTiles(renderedObject.bounds, worldToCamera, vLights);
+			MarkDirtyTiles(object.bounds, worldToCamera, vLights);
+		}
+
+		if (!m_IsFullFrame)
+			for (int tileIndex{}; tileIndex < m_vTiles.size(); ++tileIndex)
+				if (m_vAreTilesDirty[GetTileGridIndex(m_vTiles[tileIndex].x, m_vTiles[tileIndex].y)])
+					m_vDirtyTileIndices.push_back(tileIndex);
+	}
+
+	m_vRenderedObjects.swap(m_vObjects);
+	m_vRenderedSpheres = vSpheres;
+	m_vRenderedPlanes = vPlanes;
+	m_vRenderedLights = vLights;
+	m_RenderedMaterialAmount = static_cast<int>(vpMaterials.size());
+	m_RenderedCameraToWorld = camera.GetCameraToWorld();
+	m_RenderedFieldOfViewValue = camera.GetFieldOfViewValue();
+
+	//	Changed objects can also show up in the reflections of other tiles, those keep their accumulation nonetheless
+	if (m_IsReflecting)
+		ResetDirtyTileAccumulation();
+
+	UpdatePreviewScale(isCameraMoving, !m_IsFullFrame && m_vDirtyTileIndices.empty());
+
+	//	Reflections keep accumulating in every tile, a preview gets refined everywhere, and without skipping every frame gets traced completely
+	if (m_IsReflecting || m_PreviewScale > 1 || m_ImageScale > 1 || (!m_IsSkippingUnchangedFrames && m_vDirtyTileIndices.empty()))
+		MarkAllTilesDirty();
+}
+
+void Renderer::ResetDirtyTileAccumulation()
+{
+	for (int tileIndex : m_vDirtyTileIndices)
+	{
+		const Tile& tile{ m_vTiles[tileIndex] };
+		const SDL_Rect rect{ GetTileRect(tile) };
+		for (int pixelY{ rect.y }; pixelY < rect.y + rect.h; ++pixelY)
+			std::fill_n(m_vAccumulatedReflectionData.begin() + rect.x + pixelY * m_Width, rect.w, ColorRGB(0.0f, 0.0f, 0.0f));
+
+		m_vTileFrameIndices[GetTileGridIndex(tile.x, tile.y)] = 1;
+	}
+}
+
+void Renderer::MarkDirtyTiles(const AABB& bounds, const Matrix& worldToCamera, const std::vector<Light>& vLights)
+{
+	//	Anything closer to the camera plane counts as crossing it
+	static constexpr float NEAR_DISTANCE{ 0.01f };
+
+	Vector3 aCorners[8];
+	for (int corner{}; corner < 8; ++corner)
+		aCorners[corner] = Vector3
+		(
+			(corner & 1) ? bounds.largest.x : bounds.smallest.x,
+			(corner & 2) ? bounds.largest.y : bounds.smallest.y,
+			(corner & 4) ? bounds.largest.z : bounds.smallest.z
+		);
+
+	worldToCamera.TransformPoints(aCorners, aCorners, 8);
+
+	const float aspectRatioTimesFieldOfViewValue{ float(m_Width) / m_Height * m_RenderedFieldOfViewValue };
+
+	float
+		smallestX{ FLT_MAX },
+		smallestY{ FLT_MAX },
+		largestX{ -FLT_MAX },
+		largestY{ -FLT_MAX };
+
+	bool isCoveringScreen{ false };
+
+	//	The inverse of the ray generation, the screen position of the view ray along the camera space direction
+	const auto grow
+	{
+		[&](const Vector3& direction)
+		{
+			const float
+				x{ (direction.x / direction.z / aspectRatioTimesFieldOfViewValue + 1.0f) * 0.5f * m_Width },
+				y{ (1.0f - direction.y / direction.z / m_RenderedFieldOfViewValue) * 0.5f * m_Height };
+
+			if (!std::isfinite(x) || !std::isfinite(y))
+				isCoveringScreen = true;
+
+			smallestX = std::min(x, smallestX);
+			smallestY = std::min(y, smallestY);
+			largestX = std::max(x, largestX);
+			largestY = std::max(y, largestY);
+		}
+	};
+
+	for (const Vector3& corner : aCorners)
+	{
+		if (corner.z < NEAR_DISTANCE)
+			isCoveringScreen = true;
+		else
+			grow(corner);
+	}
+
+	//	Everything a light can't see through the bounds lies in the bounds extruded away from it. Every extruded edge either runs
+	//	towards the vanishing point of its direction or gets cut off at the camera plane, the projection of that volume is the hull
+	//	of those points and the corners
+	if (m_CastShadows && !isCoveringScreen)
+		for (const Light& light : vLights)
+		{
+			const Vector3 lightOrigin{ worldToCamera.TransformPoint(light.origin) };
+			for (const Vector3& corner : aCorners)
+			{
+				const Vector3 extrusion{ corner - lightOrigin };
+				if (extrusion.z > 0.0f)
+					grow(extrusion);
+				else if (extrusion.z < 0.0f)
+					grow(corner + extrusion * ((NEAR_DISTANCE - corner.z) / extrusion.z));
+				else
+					isCoveringScreen = true;
+			}
+		}
+
+	if (isCoveringScreen)
+	{
+		MarkAllTilesDirty();
+		return;
+	}
+
+	//	One pixel of margin against rounding
+	if (largestX < -1.0f || largestY < -1.0f || smallestX > m_Width + 1.0f || smallestY > m_Height + 1.0f)
+		return;
+
+	const int
+		firstTileX{ int(std::max(smallestX - 1.0f, 0.0f)) / m_TileSize },
+		firstTileY{ int(std::max(smallestY - 1.0f, 0.0f)) / m_TileSize },
+		lastTileX{ int(std::min(largestX + 1.0f, m_Width - 1.0f)) / m_TileSize },
+		lastTileY{ int(std::min(largestY + 1.0f, m_Height - 1.0f)) / m_TileSize };
+
+	for (int tileY{ firstTileY }; tileY <= lastTileY; ++tileY)
+		std::fill(m_vAreTilesDirty.begin() + tileY * m_TileAmountX + firstTileX, m_vAreTilesDirty.begin() + tileY * m_TileAmountX + lastTileX + 1, true);
+}
+
+void Renderer::UpdatePreviewScale(bool isCameraMoving, bool didNothingChange)
+{
+	m_IsReusingSamples = false;
+
+	//	The wavefront renderer always traces every pixel
+	if (!m_IsPreviewing || m_IsWavefront)
+		m_PreviewScale = 1;
+	else if (isCameraMoving)
+	{
+		//	Estimated from the cost per traced pixel of the last frames, the first frame has no estimate yet and traces every pixel
+		m_PreviewScale = 1;
+		while (m_PreviewScale < MAXIMAL_PREVIEW_SCALE && m_TracedPixelTime * m_Width * m_Height / (m_PreviewScale * m_PreviewScale) > m_TargetFrameTime)
+			m_PreviewScale *= 2;
+	}
+	else if (m_ImageScale > 1)
+	{
+		m_PreviewScale = m_ImageScale / 2;
+
+		//	The full resolution frame of reflections has to trace every pixel to accumulate it
+		m_IsReusingSamples = didNothingChange && !(m_IsReflecting && m_PreviewScale == 1);
+	}
+	else
+		m_PreviewScale = 1;
+}
+
+void Renderer::UpsamplePreview(int tileIndex)
+{
+	//	Samples whose hit distances differ more than this relative to the nearest sample lie across an edge
+	static constexpr float DEPTH_TOLERANCE{ 0.1f };
+
+	const SDL_Rect rect{ GetTileRect(m_vTiles[tileIndex]) };
+	const int
+		scale{ m_PreviewScale },
+		lastSampleX{ (m_Width - 1) / scale * scale },
+		lastSampleY{ (m_Height - 1) / scale * scale };
+
+	for (int pixelY{ rect.y }; pixelY < rect.y + rect.h; ++pixelY)
+		for (int pixelX{ rect.x }; pixelX < rect.x + rect.w; ++pixelX)
+		{
+			const int
+				offsetX{ pixelX % scale },
+				offsetY{ pixelY % scale },
+				aSamplesX[2]{ pixelX - offsetX, std::min(pixelX - offsetX + scale, lastSampleX) },
+				aSamplesY[2]{ pixelY - offsetY, std::min(pixelY - offsetY + scale, lastSampleY) };
+
+			const float
+				weightX{ float(offsetX) / scale },
+				weightY{ float(offsetY) / scale },
+				nearestDepth{ m_vPreviewDepths[aSamplesX[offsetX * 2 >= scale] + aSamplesY[offsetY * 2 >= scale] * m_Width] };
+
+			//	Bilinear, leaving out the samples on the other side of an edge, the nearest sample always contributes
+			ColorRGB finalColor{};
+			float weightSum{};
+			for (int sample{}; sample < 4; ++sample)
+			{
+				const int
+					sampleX{ aSamplesX[sample & 1] },
+					sampleY{ aSamplesY[sample >> 1] },
+					sampleIndex{ sampleX + sampleY * m_Width };
+
+				if (std::abs(m_vPreviewDepths[sampleIndex] - nearestDepth) > DEPTH_TOLERANCE * nearestDepth)
+					continue;
+
+				const float weight{ ((sample & 1) ? weightX : 1.0f - weightX) * ((sample >> 1) ? weightY : 1.0f - weightY) };
+				finalColor += weight * m_vPreviewColors[sampleIndex];
+				weightSum += weight;
+			}
+
+			m_vFrameColors[pixelX + pixelY * m_Width] = finalColor / weightSum;
+		}
+
+	for (int pixelY{ rect.y }; pixelY < rect.y + rect.h; ++pixelY)
+		WritePixels(&m_vFrameColors[rect.x + pixelY * m_Width], rect.x + pixelY * m_Width, rect.w);
+}
+
+void Renderer::WritePixels(const ColorRGB* pColors, int firstPixelIndex, int amount)
+{
+	DispatchInstructionSet(m_InstructionSet,
+		[this, pColors, firstPixelIndex, amount](auto instructionSet)
+		{
+			WritePixels<decltype(instructionSet)::value>(pColors, firstPixelIndex, amount);
+		});
+}
+
+template<InstructionSet INSTRUCTION_SET>
+void Renderer::WritePixels(const ColorRGB* pColors, int firstPixelIndex, int amount)
+{
+	using Lanes = FloatLanes<INSTRUCTION_SET>;
+
+	const SDL_PixelFormat& format{ *m_pBuffer->format };
+	const typename Lanes::Type maxChannelValue{ Lanes::Set(255.0f) };
+	const typename Lanes::IntegerType alpha{ Lanes::SetIntegers(static_cast<int>(format.Amask)) };
+
+	const auto getChannel
+	{
+		[&maxChannelValue](const float* pValues, int shift)
+		{
+			return Lanes::ShiftLeft(Lanes::ConvertToIntegers(Lanes::Multiply(Lanes::Load(pValues), maxChannelValue)), shift);
+		}
+	};
+
+	uint32_t* const pPixels{ m_pBufferPixels + firstPixelIndex };
+	int index{};
+	for (; index + Lanes::WIDTH <= amount; index += Lanes::WIDTH)
+	{
+		float
+			aReds[Lanes::WIDTH],
+			aGreens[Lanes::WIDTH],
+			aBlues[Lanes::WIDTH];
+
+		for (int lane{}; lane < Lanes::WIDTH; ++lane)
+		{
+			aReds[lane] = pColors[index + lane].red;
+			aGreens[lane] = pColors[index + lane].green;
+			aBlues[lane] = pColors[index + lane].blue;
+		}
+
+		Lanes::StoreIntegers(pPixels + index,
+			Lanes::Or(Lanes::Or(getChannel(aReds, format.Rshift), getChannel(aGreens, format.Gshift)), Lanes::Or(getChannel(aBlues, format.Bshift), alpha)));
+	}
+
+	for (; index < amount; ++index)
+		pPixels[index] = SDL_MapRGB(&format,
+			static_cast<uint8_t>(pColors[index].red * 255),
+			static_cast<uint8_t>(pColors[index].green * 255),
+			static_cast<uint8_t>(pColors[index].blue * 255));
+}
+
+void Renderer::MarkAllTilesDirty()
+{
+	m_IsFullFrame = true;
+	std::fill(m_vAreTilesDirty.begin(), m_vAreTilesDirty.end(), true);
+	m_vDirtyTileIndices.resize(m_vTiles.size());
+	std::iota(m_vDirtyTileIndices.begin(), m_vDirtyTileIndices.end(), 0);
+}
+
+void Renderer::OnSettingChanged()
+{
+	m_AreSettingsChanged = true;
+	ResetAccumulatedReflectionData();
+}
+
+Renderer::RenderKernel Renderer::GetRenderKernel() const
+{
+	switch (m_LightingMode)
+	{
+	case Renderer::LightingMode::observedArea:
+		return GetRenderKernel<LightingMode::observedArea>();
+
+	case Renderer::LightingMode::radiance:
+		return GetRenderKernel<LightingMode::radiance>();
+
+	case Renderer::LightingMode::BRDF:
+		return GetRenderKernel<LightingMode::BRDF>();
+
+	case Renderer::LightingMode::combined:
+		return GetRenderKernel<LightingMode::combined>();
+
+	//	Only counts the lighting modes
+	case Renderer::LightingMode::AMOUNT:
+		break;
+	}
+
+	return GetRenderKernel<LightingMode::combined>();
+}
+
+template<Renderer::LightingMode LIGHTING_MODE>
+Renderer::RenderKernel Renderer::GetRenderKernel() const
+{
+	if (m_IsWavefront)
+	{
+		if (m_IsReflecting)
+			return m_CastShadows ? &Renderer::RenderWavefront<LIGHTING_MODE, true, true> : &Renderer::RenderWavefront<LIGHTING_MODE, false, true>;
+
+		return m_CastShadows ? &Renderer::RenderWavefront<LIGHTING_MODE, true, false> : &Renderer::RenderWavefront<LIGHTING_MODE, false, false>;
+	}
+
+	if (m_IsReflecting)
+		return m_CastShadows ? &Renderer::RenderPackets<LIGHTING_MODE, true, true> : &Renderer::RenderPackets<LIGHTING_MODE, false, true>;
+
+	return m_CastShadows ? &Renderer::RenderPackets<LIGHTING_MODE, true, false> : &Renderer::RenderPackets<LIGHTING_MODE, false, false>;
+}
+
+template<Renderer::LightingMode LIGHTING_MODE, bool CAST_SHADOWS, bool IS_REFLECTING>
+void Renderer::RenderPackets(const Camera& camera)
+{
 	const auto& vpMaterials{ m_pScene->GetMaterials() };
 	const auto& vLights{ m_pScene->GetLights() };
 
@@ -52,126 +623,594 @@ void Renderer::Render()
 	const Vector3& cameraOrigin{ camera.GetOrigin() };
 	const Matrix& cameraToWorld{ camera.GetCameraToWorld() };
 
-	std::for_each(std::execution::par, m_PixelsY.begin(), m_PixelsY.end(),
-		[this, &vpMaterials, &vLights, fieldOfViewValue, aspectRatioTimesFieldOfViewValue, multiplierXValue, multiplierYValue, &cameraOrigin, &cameraToWorld]
-		(float py)
+	const uint64_t startTime{ SDL_GetPerformanceCounter() };
+
+	//	A preview packet spreads its lanes over every scale-th pixel, a refinement skips the pixels the previous preview traced
+	const int
+		scale{ m_PreviewScale },
+		reusedScale{ m_IsReusingSamples ? scale * 2 : 0 };
+
+	const bool isPreview{ scale > 1 || m_IsReusingSamples };
+
+	m_ThreadPool.Run(static_cast<int>(m_vDirtyTileIndices.size()),
+		[this, &vpMaterials, &vLights, fieldOfViewValue, aspectRatioTimesFieldOfViewValue, multiplierXValue, multiplierYValue, &cameraOrigin, &cameraToWorld, scale, reusedScale, isPreview]
+		(int dirtyTileIndex)
 		{
-			Vector3 rayDirection;
-			rayDirection.z = 1.0f;
-			rayDirection.y = (1.0f - py * multiplierYValue) * fieldOfViewValue;
+			const Tile& tile{ m_vTiles[m_vDirtyTileIndices[dirtyTileIndex]] };
+			const int
+				tileEndX{ std::min(tile.x + m_TileSize, m_Width) },
+				tileEndY{ std::min(tile.y + m_TileSize, m_Height) },
+				packetAmountX{ (tileEndX - tile.x + RayPacket::WIDTH * scale - 1) / (RayPacket::WIDTH * scale) },
+				packetAmountY{ (tileEndY - tile.y + RayPacket::HEIGHT * scale - 1) / (RayPacket::HEIGHT * scale) },
+				frameIndex{ m_vTileFrameIndices[GetTileGridIndex(tile.x, tile.y)] };
+
+			std::vector<int> vOccludedLaneMasks(vLights.size());
 
-			for (float px{ 0.5f }; px < m_Width; ++px)
+			for (int packetIndex{}; packetIndex < packetAmountX * packetAmountY; ++packetIndex)
 			{
-				rayDirection.x = (px * multiplierXValue - 1.0f) * aspectRatioTimesFieldOfViewValue;
+				const int
+					packetX{ tile.x + packetIndex % packetAmountX * RayPacket::WIDTH * scale },
+					packetY{ tile.y + packetIndex / packetAmountX * RayPacket::HEIGHT * scale };
+
+				int packetLaneMask{};
+				for (int lane{}; lane < RayPacket::SIZE; ++lane)
+				{
+					const int
+						pixelX{ packetX + lane % RayPacket::WIDTH * scale },
+						pixelY{ packetY + lane / RayPacket::WIDTH * scale };
 
-				const int currentPixelIndex{ int(px) + (int(py) * m_Width) };
+					if (pixelX < tileEndX && pixelY < tileEndY && !(reusedScale && pixelX % reusedScale == 0 && pixelY % reusedScale == 0))
+						packetLaneMask |= 1 << lane;
+				}
 
-				Ray viewRay;
-				viewRay.origin = cameraOrigin;
-				viewRay.direction = cameraToWorld.TransformVector(rayDirection.GetNormalized());
+				if (!packetLaneMask)
+					continue;
 
-				ColorRGB finalColor{};
-#ifdef REFLECT
-				float colorFragmentLeftToUse{ 1.0f };
-				for (int reflectionBounceAmount{ 0 }; reflectionBounceAmount <= m_ReflectionBounceAmount; ++reflectionBounceAmount)
+				//	The primary rays and the shadow rays of their hits get traced as packets of neighbouring pixels
+				RayPacket viewPacket{};
+#ifdef SIMD_MATH
+				//	The eight lane path needs AVX, older CPUs take the scalar loop
+				if (m_InstructionSet != InstructionSet::SSE)
 				{
-#endif
-					HitRecord closestHit;
-					m_pScene->GetClosestHit(viewRay, closestHit);
-					if (closestHit.didHit)
+					for (int firstLane{}; firstLane < RayPacket::SIZE; firstLane += Vector3x8::WIDTH)
 					{
-						const Material* const pHitMaterial{ vpMaterials[closestHit.materialIndex] };
-#ifdef REFLECT
-						const float colorFragmentUsed{ colorFragmentLeftToUse * pHitMaterial->m_Roughness };
-						colorFragmentLeftToUse -= colorFragmentUsed;
+						alignas(32) float
+							aPixelsX[Vector3x8::WIDTH],
+							aPixelsY[Vector3x8::WIDTH];
+
+						const int laneMask{ (packetLaneMask >> firstLane) & ((1 << Vector3x8::WIDTH) - 1) };
+						for (int lane{}; lane < Vector3x8::WIDTH; ++lane)
+						{
+							aPixelsX[lane] = packetX + (firstLane + lane) % RayPacket::WIDTH * scale + 0.5f;
+							aPixelsY[lane] = packetY + (firstLane + lane) / RayPacket::WIDTH * scale + 0.5f;
+						}
+
+						const Vector3x8 rayDirections
+						(
+							_mm256_mul_ps(_mm256_sub_ps(_mm256_mul_ps(_mm256_load_ps(aPixelsX), _mm256_set1_ps(multiplierXValue)), _mm256_set1_ps(1.0f)), _mm256_set1_ps(aspectRatioTimesFieldOfViewValue)),
+							_mm256_mul_ps(_mm256_sub_ps(_mm256_set1_ps(1.0f), _mm256_mul_ps(_mm256_load_ps(aPixelsY), _mm256_set1_ps(multiplierYValue))), _mm256_set1_ps(fieldOfViewValue)),
+							_mm256_set1_ps(1.0f)
+						);
+
+						viewPacket.SetRays(firstLane, cameraOrigin, cameraToWorld.TransformVector(rayDirections.GetNormalized()), laneMask);
+					}
+				}
+				else
 #endif
-						for (const Light& light : vLights)
+				for (int lane{}; lane < RayPacket::SIZE; ++lane)
+				{
+					const int
+						pixelX{ packetX + lane % RayPacket::WIDTH * scale },
+						pixelY{ packetY + lane / RayPacket::WIDTH * scale };
+
+					if (!((packetLaneMask >> lane) & 1))
+						continue;
+
+					const float
+						px{ pixelX + 0.5f },
+						py{ pixelY + 0.5f };
+
+					Vector3 rayDirection;
+					rayDirection.x = (px * multiplierXValue - 1.0f) * aspectRatioTimesFieldOfViewValue;
+					rayDirection.y = (1.0f - py * multiplierYValue) * fieldOfViewValue;
+					rayDirection.z = 1.0f;
+
+					Ray viewRay;
+					viewRay.origin = cameraOrigin;
+					viewRay.direction = cameraToWorld.TransformVector(rayDirection.GetNormalized());
+					viewPacket.SetRay(lane, viewRay);
+				}
+
+				HitRecord aClosestHits[RayPacket::SIZE];
+				m_pScene->GetClosestHit(viewPacket, aClosestHits);
+
+				SurfacePoint aSurfacePoints[RayPacket::SIZE];
+				for (int mask{ viewPacket.activeMask }; mask; mask &= mask - 1)
+				{
+					const int lane{ std::countr_zero(static_cast<unsigned int>(mask)) };
+					if (aClosestHits[lane].didHit)
+						aSurfacePoints[lane] = m_pScene->GetSurfacePoint(viewPacket.GetRay(lane), aClosestHits[lane]);
+				}
+
+				if constexpr (CAST_SHADOWS)
+					for (int lightIndex{}; lightIndex < vLights.size(); ++lightIndex)
+					{
+						RayPacket lightPacket{};
+						for (int mask{ viewPacket.activeMask }; mask; mask &= mask - 1)
 						{
-							const Vector3 lightVector{ GetDirectionToLight(light, closestHit.origin) };
-							const float lightVectorMagnitude{ lightVector.GetMagnitude() };
-							const Vector3 lightVectorNormalized{ lightVector / lightVectorMagnitude };
+							const int lane{ std::countr_zero(static_cast<unsigned int>(mask)) };
+							if (aClosestHits[lane].didHit)
+								lightPacket.SetRay(lane, GetLightRay(vLights[lightIndex], aSurfacePoints[lane].origin));
+						}
 
-							Ray lightRay{ closestHit.origin + RAY_EPSILON * lightVectorNormalized, lightVectorNormalized };
-							lightRay.max = lightVectorMagnitude;
+						vOccludedLaneMasks[lightIndex] = m_pScene->DoesHit(lightPacket);
+					}
 
-							if (m_CastShadows && m_pScene->DoesHit(lightRay))
-								continue;
+				for (int mask{ viewPacket.activeMask }; mask; mask &= mask - 1)
+				{
+					const int
+						lane{ std::countr_zero(static_cast<unsigned int>(mask)) },
+						currentPixelIndex{ packetX + lane % RayPacket::WIDTH * scale + (packetY + lane / RayPacket::WIDTH * scale) * m_Width };
 
-							const float dotLightDirectionNormal{ std::max(Vector3::Dot(lightRay.direction, closestHit.normal), 0.0f) };
-							const ColorRGB radiance{ GetRadiance(light, closestHit.origin) };
-							const ColorRGB BRDF{ pHitMaterial->Shade(closestHit, lightRay.direction, viewRay.direction) };
+					Ray viewRay{ viewPacket.GetRay(lane) };
 
-							switch (m_LightingMode)
-							{
-							case Renderer::LightingMode::observedArea:
-								finalColor +=
-#ifdef REFLECT
-									colorFragmentUsed *
-#endif
-									dotLightDirectionNormal * WHITE;
-								break;
+					ColorRGB finalColor{};
+					float colorFragmentLeftToUse{ 1.0f };
+					for (int reflectionBounceAmount{ 0 }; reflectionBounceAmount <= (IS_REFLECTING ? m_ReflectionBounceAmount : 0); ++reflectionBounceAmount)
+					{
+						const bool isPrimaryRay{ reflectionBounceAmount == 0 };
 
-							case Renderer::LightingMode::radiance:
-								finalColor +=
-#ifdef REFLECT
-									colorFragmentUsed *
-#endif
-									radiance;
-								break;
-
-							case Renderer::LightingMode::BRDF:
-								finalColor +=
-#ifdef REFLECT
-									colorFragmentUsed *
-									BRDF.GetMaxToOne();
-#else
-									BRDF;
-#endif
-								break;
-
-							case Renderer::LightingMode::combined:
-								finalColor +=
-									dotLightDirectionNormal *
-									radiance *
-#ifdef REFLECT
-									colorFragmentUsed *
-									BRDF.GetMaxToOne();
-#else
-									BRDF;
-#endif
-								break;
-							}
+						HitRecord closestHit;
+						if (isPrimaryRay)
+							closestHit = aClosestHits[lane];
+						else
+							m_pScene->GetClosestHit(viewRay, closestHit);
+
+						if (!closestHit.didHit)
+							break;
+
+						const SurfacePoint surfacePoint{ isPrimaryRay ? aSurfacePoints[lane] : m_pScene->GetSurfacePoint(viewRay, closestHit) };
+						const Material* const pHitMaterial{ vpMaterials[surfacePoint.materialIndex] };
+
+						float colorFragmentUsed{ 1.0f };
+						if constexpr (IS_REFLECTING)
+						{
+							colorFragmentUsed = colorFragmentLeftToUse * pHitMaterial->m_Roughness;
+							colorFragmentLeftToUse -= colorFragmentUsed;
 						}
-#ifdef REFLECT
-						if (colorFragmentLeftToUse >= FLT_EPSILON)
+
+						for (int lightIndex{}; lightIndex < vLights.size(); ++lightIndex)
 						{
-							viewRay.direction = (Vector3::Reflect(viewRay.direction, closestHit.normal) + pHitMaterial->m_Roughness * Vector3::GetRandom(-0.2f, 0.2f)).GetNormalized();
-							viewRay.origin = closestHit.origin;
+							const Light& light{ vLights[lightIndex] };
+							const Ray lightRay{ GetLightRay(light, surfacePoint.origin) };
+
+							if constexpr (CAST_SHADOWS)
+								if (isPrimaryRay ? bool((vOccludedLaneMasks[lightIndex] >> lane) & 1) : m_pScene->DoesHit(lightRay))
+									continue;
+
+							const ColorRGB lightContribution{ GetLightContribution<LIGHTING_MODE, IS_REFLECTING>(*pHitMaterial, surfacePoint, light, lightRay.direction, viewRay.direction) };
+							if constexpr (IS_REFLECTING)
+								finalColor += colorFragmentUsed * lightContribution;
+							else
+								finalColor += lightContribution;
 						}
-						else
+
+						if (!IS_REFLECTING || colorFragmentLeftToUse < FLT_EPSILON)
 							break;
-#endif
+
+						const Sampler sampler{ m_SamplerType, currentPixelIndex, frameIndex - 1 };
+						viewRay.direction = (Vector3::Reflect(viewRay.direction, surfacePoint.normal) + pHitMaterial->m_Roughness * sampler.GetVector3(reflectionBounceAmount, -0.2f, 0.2f)).GetNormalized();
+						viewRay.origin = surfacePoint.origin;
+					}
+
+					if constexpr (IS_REFLECTING)
+						if (!isPreview)
+						{
+							m_vAccumulatedReflectionData[currentPixelIndex] += finalColor;
+							finalColor = m_vAccumulatedReflectionData[currentPixelIndex] / float(frameIndex);
+						}
+
+					finalColor.MaxToOne();
+
+					if (isPreview)
+					{
+						m_vPreviewColors[currentPixelIndex] = finalColor;
+						m_vPreviewDepths[currentPixelIndex] = aClosestHits[lane].didHit ? aClosestHits[lane].t : FLT_MAX;
+						continue;
 					}
-#ifdef REFLECT
+
+					m_vFrameColors[currentPixelIndex] = finalColor;
 				}
+			}
 
-				m_vAccumulatedReflectionData[currentPixelIndex] += finalColor;
-				finalColor = m_vAccumulatedReflectionData[currentPixelIndex] / float(m_FrameIndex);
-#endif
-				finalColor.MaxToOne();
+			if (!isPreview)
+				for (int pixelY{ tile.y }; pixelY < tileEndY; ++pixelY)
+					WritePixels(&m_vFrameColors[tile.x + pixelY * m_Width], tile.x + pixelY * m_Width, tileEndX - tile.x);
+		});
+
+	//	The gaps can only be filled once the neighbouring tiles traced their samples
+	if (isPreview)
+		m_ThreadPool.Run(static_cast<int>(m_vDirtyTileIndices.size()),
+			[this](int dirtyTileIndex)
+			{
+				UpsamplePreview(m_vDirtyTileIndices[dirtyTileIndex]);
+			});
+
+	//	Per traced pixel, so it also predicts the cost of other preview scales
+	const float
+		tracedPixelAmount{ float(m_Width) * m_Height * m_vDirtyTileIndices.size() / m_vTiles.size() / (scale * scale) * (m_IsReusingSamples ? 0.75f : 1.0f) },
+		tracedPixelTime{ float(SDL_GetPerformanceCounter() - startTime) / SDL_GetPerformanceFrequency() / tracedPixelAmount };
+
+	m_TracedPixelTime = m_TracedPixelTime > 0.0f ? (m_TracedPixelTime + tracedPixelTime) * 0.5f : tracedPixelTime;
+}
+
+//	Only computes the terms the lighting mode uses
+template<Renderer::LightingMode LIGHTING_MODE, bool IS_REFLECTING>
+ColorRGB Renderer::GetLightContribution(const Material& material, const SurfacePoint& surfacePoint, const Light& light, const Vector3& lightDirection, const Vector3& viewDirection) const
+{
+	const auto getBRDF
+	{
+		[&material, &surfacePoint, &lightDirection, &viewDirection]()
+		{
+			if constexpr (IS_REFLECTING)
+				return material.Shade(surfacePoint, lightDirection, viewDirection).GetMaxToOne();
+			else
+				return material.Shade(surfacePoint, lightDirection, viewDirection);
+		}
+	};
+
+	if constexpr (LIGHTING_MODE == LightingMode::observedArea)
+		return std::max(Vector3::Dot(lightDirection, surfacePoint.normal), 0.0f) * WHITE;
+	else if constexpr (LIGHTING_MODE == LightingMode::radiance)
+		return GetRadiance(light, surfacePoint.origin);
+	else if constexpr (LIGHTING_MODE == LightingMode::BRDF)
+		return getBRDF();
+	else
+		return std::max(Vector3::Dot(lightDirection, surfacePoint.normal), 0.0f) * GetRadiance(light, surfacePoint.origin) * getBRDF();
+}
 
-				m_pBufferPixels[currentPixelIndex] = SDL_MapRGB(m_pBuffer->format,
-					static_cast<uint8_t>(finalColor.red * 255),
-					static_cast<uint8_t>(finalColor.green * 255),
-					static_cast<uint8_t>(finalColor.blue * 255));
+template<typename Function>
+void Renderer::RunPathChunks(int pathAmount, const Function& function)
+{
+	m_ThreadPool.Run((pathAmount + PATH_CHUNK_SIZE - 1) / PATH_CHUNK_SIZE,
+		[pathAmount, &function](int chunkIndex)
+		{
+			const int firstPath{ chunkIndex * PATH_CHUNK_SIZE };
+			function(firstPath, std::min(firstPath + PATH_CHUNK_SIZE, pathAmount));
+		});
+}
+
+template<Renderer::LightingMode LIGHTING_MODE, bool CAST_SHADOWS, bool IS_REFLECTING>
+void Renderer::RenderWavefront(const Camera& camera)
+{
+	const auto& vpMaterials{ m_pScene->GetMaterials() };
+	const auto& vLights{ m_pScene->GetLights() };
+
+	const int
+		lightAmount{ static_cast<int>(vLights.size()) },
+		pixelAmount{ m_Width * m_Height };
+
+	const float
+		fieldOfViewValue{ camera.GetFieldOfViewValue() },
+		aspectRatioTimesFieldOfViewValue{ float(m_Width) / m_Height * fieldOfViewValue },
+		multiplierXValue{ 2.0f / m_Width },
+		multiplierYValue{ 2.0f / m_Height };
+
+	const Vector3& cameraOrigin{ camera.GetOrigin() };
+	const Matrix& cameraToWorld{ camera.GetCameraToWorld() };
+
+	PathQueue& queue{ m_PathQueue };
+
+	//	Ray generation, pixels get queued in blocks of packet size so the primary rays can be traced as packets.
+	//	Tiles are made of whole packets, the pixels of clean tiles don't get copied out of the render pixels
+	queue.Resize(pixelAmount);
+	if constexpr (IS_REFLECTING)
+		m_BouncingPathQueue.Resize(pixelAmount);
+
+	int pathAmount{};
+	for (int packetY{}; packetY < m_Height; packetY += RayPacket::HEIGHT)
+		for (int packetX{}; packetX < m_Width; packetX += RayPacket::WIDTH)
+			for (int lane{}; lane < RayPacket::SIZE && m_vAreTilesDirty[GetTileGridIndex(packetX, packetY)]; ++lane)
+			{
+				const int
+					pixelX{ packetX + lane % RayPacket::WIDTH },
+					pixelY{ packetY + lane / RayPacket::WIDTH };
+
+				if (pixelX < m_Width && pixelY < m_Height)
+					queue.vPixelIndices[pathAmount++] = pixelX + pixelY * m_Width;
+			}
+
+	RunPathChunks(pathAmount,
+		[this, &queue, fieldOfViewValue, aspectRatioTimesFieldOfViewValue, multiplierXValue, multiplierYValue, &cameraOrigin, &cameraToWorld](int firstPath, int endPath)
+		{
+			for (int path{ firstPath }; path < endPath; ++path)
+			{
+				const float
+					px{ queue.vPixelIndices[path] % m_Width + 0.5f },
+					py{ queue.vPixelIndices[path] / m_Width + 0.5f };
+
+				Vector3 rayDirection;
+				rayDirection.x = (px * multiplierXValue - 1.0f) * aspectRatioTimesFieldOfViewValue;
+				rayDirection.y = (1.0f - py * multiplierYValue) * fieldOfViewValue;
+				rayDirection.z = 1.0f;
+
+				queue.vOrigins[path] = cameraOrigin;
+				queue.vDirections[path] = cameraToWorld.TransformVector(rayDirection.GetNormalized());
+				queue.vColorFragmentsLeftToUse[path] = 1.0f;
+				m_vFrameColors[queue.vPixelIndices[path]] = ColorRGB(0.0f, 0.0f, 0.0f);
 			}
 		});
 
-#ifdef REFLECT
-	++m_FrameIndex;
+	for (int reflectionBounceAmount{ 0 }; reflectionBounceAmount <= (IS_REFLECTING ? m_ReflectionBounceAmount : 0) && pathAmount; ++reflectionBounceAmount)
+	{
+		//	Only the primary rays and their shadow rays are coherent enough for packets
+		const bool isPrimaryRay{ reflectionBounceAmount == 0 };
+		const int
+			materialAmount{ static_cast<int>(vpMaterials.size()) },
+			chunkAmount{ (pathAmount + PATH_CHUNK_SIZE - 1) / PATH_CHUNK_SIZE };
+
+		//	Extension: the closest hit of every path
+		if (isPrimaryRay)
+			RunPathChunks(pathAmount,
+				[this, &queue](int firstPath, int endPath)
+				{
+					for (int packetPath{ firstPath }; packetPath < endPath; packetPath += RayPacket::SIZE)
+					{
+						const int laneAmount{ std::min(RayPacket::SIZE, endPath - packetPath) };
+
+						RayPacket packet{};
+						for (int lane{}; lane < laneAmount; ++lane)
+							packet.SetRay(lane, Ray(queue.vOrigins[packetPath + lane], queue.vDirections[packetPath + lane]));
+
+						HitRecord aClosestHits[RayPacket::SIZE];
+						m_pScene->GetClosestHit(packet, aClosestHits);
+						std::copy_n(aClosestHits, laneAmount, queue.vHitRecords.begin() + packetPath);
+					}
+				});
+		else
+			RunPathChunks(pathAmount,
+				[this, &queue](int firstPath, int endPath)
+				{
+					for (int path{ firstPath }; path < endPath; ++path)
+					{
+						queue.vHitRecords[path] = HitRecord();
+						m_pScene->GetClosestHit(Ray(queue.vOrigins[path], queue.vDirections[path]), queue.vHitRecords[path]);
+					}
+				});
+
+		//	Surface attributes, only built for the closest hits
+		RunPathChunks(pathAmount,
+			[this, &queue](int firstPath, int endPath)
+			{
+				for (int path{ firstPath }; path < endPath; ++path)
+					if (queue.vHitRecords[path].didHit)
+						queue.vSurfacePoints[path] = m_pScene->GetSurfacePoint(Ray(queue.vOrigins[path], queue.vDirections[path]), queue.vHitRecords[path]);
+			});
+
+		//	Shadow rays: one per path and light, paths that missed get empty rays
+		if (CAST_SHADOWS && lightAmount)
+		{
+			m_vShadowRays.resize(pathAmount * lightAmount);
+			m_vAreShadowRaysOccluded.resize(pathAmount * lightAmount);
+
+			RunPathChunks(pathAmount,
+				[this, &queue, &vLights, lightAmount](int firstPath, int endPath)
+				{
+					for (int path{ firstPath }; path < endPath; ++path)
+						for (int lightIndex{}; lightIndex < lightAmount; ++lightIndex)
+							m_vShadowRays[path * lightAmount + lightIndex] = queue.vHitRecords[path].didHit ? GetLightRay(vLights[lightIndex], queue.vSurfacePoints[path].origin) : Ray(Vector3(), Vector3(), 1.0f, 0.0f);
+				});
+
+			if (isPrimaryRay)
+				RunPathChunks(pathAmount,
+					[this, lightAmount](int firstPath, int endPath)
+					{
+						for (int packetPath{ firstPath }; packetPath < endPath; packetPath += RayPacket::SIZE)
+						{
+							const int laneAmount{ std::min(RayPacket::SIZE, endPath - packetPath) };
+							for (int lightIndex{}; lightIndex < lightAmount; ++lightIndex)
+							{
+								RayPacket packet{};
+								for (int lane{}; lane < laneAmount; ++lane)
+								{
+									const Ray& shadowRay{ m_vShadowRays[(packetPath + lane) * lightAmount + lightIndex] };
+									if (shadowRay.min <= shadowRay.max)
+										packet.SetRay(lane, shadowRay);
+								}
+
+								const int occludedMask{ m_pScene->DoesHit(packet) };
+								for (int lane{}; lane < laneAmount; ++lane)
+									m_vAreShadowRaysOccluded[(packetPath + lane) * lightAmount + lightIndex] = (occludedMask >> lane) & 1;
+							}
+						}
+					});
+			else
+				RunPathChunks(pathAmount,
+					[this, lightAmount](int firstPath, int endPath)
+					{
+						for (int index{ firstPath * lightAmount }; index < endPath * lightAmount; ++index)
+							m_vAreShadowRaysOccluded[index] = m_vShadowRays[index].min <= m_vShadowRays[index].max && m_pScene->DoesHit(m_vShadowRays[index]);
+					});
+		}
+
+		//	Counting sort of the paths that hit something by material, so every shading pass runs a single BRDF.
+		//	Every chunk counts its paths per material, the prefix sum over the materials and then the chunks keeps the paths in order
+		m_vChunkMaterialOffsets.assign(chunkAmount * materialAmount, 0);
+		RunPathChunks(pathAmount,
+			[this, &queue, materialAmount](int firstPath, int endPath)
+			{
+				int* const pMaterialCounts{ &m_vChunkMaterialOffsets[firstPath / PATH_CHUNK_SIZE * materialAmount] };
+				for (int path{ firstPath }; path < endPath; ++path)
+				{
+					queue.vAreAlive[path] = false;
+					if (queue.vHitRecords[path].didHit)
+						++pMaterialCounts[queue.vSurfacePoints[path].materialIndex];
+				}
+			});
+
+		m_vMaterialOffsets.resize(materialAmount + 1);
+		int sortedPathAmount{};
+		for (int materialIndex{}; materialIndex < materialAmount; ++materialIndex)
+		{
+			m_vMaterialOffsets[materialIndex] = sortedPathAmount;
+			for (int chunkIndex{}; chunkIndex < chunkAmount; ++chunkIndex)
+			{
+				int& chunkMaterialOffset{ m_vChunkMaterialOffsets[chunkIndex * materialAmount + materialIndex] };
+				const int chunkMaterialPathAmount{ chunkMaterialOffset };
+				chunkMaterialOffset = sortedPathAmount;
+				sortedPathAmount += chunkMaterialPathAmount;
+			}
+		}
+
+		m_vMaterialOffsets[materialAmount] = sortedPathAmount;
+
+		m_vSortedPathIndices.resize(sortedPathAmount);
+		RunPathChunks(pathAmount,
+			[this, &queue, materialAmount](int firstPath, int endPath)
+			{
+				int* const pMaterialEnds{ &m_vChunkMaterialOffsets[firstPath / PATH_CHUNK_SIZE * materialAmount] };
+				for (int path{ firstPath }; path < endPath; ++path)
+					if (queue.vHitRecords[path].didHit)
+						m_vSortedPathIndices[pMaterialEnds[queue.vSurfacePoints[path].materialIndex]++] = path;
+			});
+
+		//	Shading: every path writes to its own pixel, so the passes don't need to synchronize
+		for (int materialIndex{}; materialIndex < materialAmount; ++materialIndex)
+		{
+			const Material& material{ *vpMaterials[materialIndex] };
+			const int firstSortedIndex{ m_vMaterialOffsets[materialIndex] };
+			RunPathChunks(m_vMaterialOffsets[materialIndex + 1] - firstSortedIndex,
+				[this, &queue, &vLights, lightAmount, &material, reflectionBounceAmount, firstSortedIndex](int firstIndex, int endIndex)
+				{
+					for (int sortedIndex{ firstSortedIndex + firstIndex }; sortedIndex < firstSortedIndex + endIndex; ++sortedIndex)
+					{
+						const int path{ m_vSortedPathIndices[sortedIndex] };
+
+						const SurfacePoint& surfacePoint{ queue.vSurfacePoints[path] };
+						Vector3& viewDirection{ queue.vDirections[path] };
+
+						float& colorFragmentLeftToUse{ queue.vColorFragmentsLeftToUse[path] };
+						float colorFragmentUsed{ 1.0f };
+						if constexpr (IS_REFLECTING)
+						{
+							colorFragmentUsed = colorFragmentLeftToUse * material.m_Roughness;
+							colorFragmentLeftToUse -= colorFragmentUsed;
+						}
+
+						ColorRGB& finalColor{ m_vFrameColors[queue.vPixelIndices[path]] };
+						for (int lightIndex{}; lightIndex < lightAmount; ++lightIndex)
+						{
+							if constexpr (CAST_SHADOWS)
+								if (m_vAreShadowRaysOccluded[path * lightAmount + lightIndex])
+									continue;
+
+							const Ray lightRay{ GetLightRay(vLights[lightIndex], surfacePoint.origin) };
+							const ColorRGB lightContribution{ GetLightContribution<LIGHTING_MODE, IS_REFLECTING>(material, surfacePoint, vLights[lightIndex], lightRay.direction, viewDirection) };
+							if constexpr (IS_REFLECTING)
+								finalColor += colorFragmentUsed * lightContribution;
+							else
+								finalColor += lightContribution;
+						}
+
+						//	Bounce
+						if (IS_REFLECTING && colorFragmentLeftToUse >= FLT_EPSILON)
+						{
+							const int pixelIndex{ queue.vPixelIndices[path] };
+							const Sampler sampler{ m_SamplerType, pixelIndex, m_vTileFrameIndices[GetTileGridIndex(pixelIndex % m_Width, pixelIndex / m_Width)] - 1 };
+							viewDirection = (Vector3::Reflect(viewDirection, surfacePoint.normal) + material.m_Roughness * sampler.GetVector3(reflectionBounceAmount, -0.2f, 0.2f)).GetNormalized();
+							queue.vOrigins[path] = surfacePoint.origin;
+							queue.vAreAlive[path] = true;
+						}
+					}
+				});
+		}
+
+		//	The last bounce leaves no paths to compact
+		if (!IS_REFLECTING || reflectionBounceAmount == m_ReflectionBounceAmount)
+			break;
+
+		//	Compaction of the paths that keep bouncing into the other queue, keeping their order
+		m_vChunkBouncingPathOffsets.resize(chunkAmount);
+		RunPathChunks(pathAmount,
+			[this, &queue](int firstPath, int endPath)
+			{
+				m_vChunkBouncingPathOffsets[firstPath / PATH_CHUNK_SIZE] = static_cast<int>(std::count(queue.vAreAlive.begin() + firstPath, queue.vAreAlive.begin() + endPath, 1));
+			});
+
+		int bouncingPathAmount{};
+		for (int& chunkBouncingPathOffset : m_vChunkBouncingPathOffsets)
+		{
+			const int chunkBouncingPathAmount{ chunkBouncingPathOffset };
+			chunkBouncingPathOffset = bouncingPathAmount;
+			bouncingPathAmount += chunkBouncingPathAmount;
+		}
+
+		PathQueue& bouncingQueue{ m_BouncingPathQueue };
+		RunPathChunks(pathAmount,
+			[this, &queue, &bouncingQueue](int firstPath, int endPath)
+			{
+				int bouncingPath{ m_vChunkBouncingPathOffsets[firstPath / PATH_CHUNK_SIZE] };
+				for (int path{ firstPath }; path < endPath; ++path)
+					if (queue.vAreAlive[path])
+					{
+						bouncingQueue.vPixelIndices[bouncingPath] = queue.vPixelIndices[path];
+						bouncingQueue.vOrigins[bouncingPath] = queue.vOrigins[path];
+						bouncingQueue.vDirections[bouncingPath] = queue.vDirections[path];
+						bouncingQueue.vColorFragmentsLeftToUse[bouncingPath] = queue.vColorFragmentsLeftToUse[path];
+						++bouncingPath;
+					}
+			});
+
+		queue.SwapBouncingAttributes(bouncingQueue);
+		pathAmount = bouncingPathAmount;
+	}
+
+	//	Resolve, the pixels of clean tiles kept their accumulation and their render pixels don't get presented
+	m_ThreadPool.Run(static_cast<int>(m_vDirtyTileIndices.size()),
+		[this](int dirtyTileIndex)
+		{
+			const Tile& tile{ m_vTiles[m_vDirtyTileIndices[dirtyTileIndex]] };
+			const SDL_Rect rect{ GetTileRect(tile) };
+			const float frameIndex{ float(m_vTileFrameIndices[GetTileGridIndex(tile.x, tile.y)]) };
+
+			for (int pixelY{ rect.y }; pixelY < rect.y + rect.h; ++pixelY)
+			{
+				const int
+					firstPixelIndex{ rect.x + pixelY * m_Width },
+					endPixelIndex{ firstPixelIndex + rect.w };
+
+				int pixelIndex{ firstPixelIndex };
+#ifdef SIMD_MATH
+				//	Eight pixels at a time when the CPU has AVX, the remainder goes through the scalar loop below
+				for (; m_InstructionSet != InstructionSet::SSE && pixelIndex + ColorRGBx8::WIDTH <= endPixelIndex; pixelIndex += ColorRGBx8::WIDTH)
+				{
+					ColorRGBx8 finalColors{ ColorRGBx8::Gather(&m_vFrameColors[pixelIndex]) };
+					if constexpr (IS_REFLECTING)
+					{
+						const ColorRGBx8 accumulatedColors{ ColorRGBx8::Gather(&m_vAccumulatedReflectionData[pixelIndex]) + finalColors };
+						accumulatedColors.Scatter(&m_vAccumulatedReflectionData[pixelIndex]);
+						finalColors = accumulatedColors / _mm256_set1_ps(frameIndex);
+					}
+
+					finalColors.GetMaxToOne().Scatter(&m_vFrameColors[pixelIndex]);
+				}
 #endif
+				for (; pixelIndex < endPixelIndex; ++pixelIndex)
+				{
+					ColorRGB finalColor{ m_vFrameColors[pixelIndex] };
+					if constexpr (IS_REFLECTING)
+					{
+						m_vAccumulatedReflectionData[pixelIndex] += finalColor;
+						finalColor = m_vAccumulatedReflectionData[pixelIndex] / frameIndex;
+					}
+
+					finalColor.MaxToOne();
+					m_vFrameColors[pixelIndex] = finalColor;
+				}
 
-	SDL_UpdateWindowSurface(m_pWindow);
+				WritePixels(&m_vFrameColors[firstPixelIndex], firstPixelIndex, rect.w);
+			}
+		});
 }
 
 bool Renderer::SaveBufferToImage() const
@@ -222,9 +1261,7 @@ void Renderer::CycleLightingMode()
 		break;
 	}
 
-#ifdef REFLECT
-	ResetAccumulatedReflectionData();
-#endif
+	OnSettingChanged();
 }
 
 void Renderer::ToggleShadows()
@@ -237,12 +1274,74 @@ void Renderer::ToggleShadows()
 		<< "SHADOWS: " << std::boolalpha << m_CastShadows << std::endl
 		<< "--------\n";
 
-#ifdef REFLECT
-	ResetAccumulatedReflectionData();
-#endif
+	OnSettingChanged();
+}
+
+void Renderer::ToggleReflections()
+{
+	m_IsReflecting = !m_IsReflecting;
+	system("CLS");
+	std::cout
+		<< CONTROLS
+		<< "--------\n"
+		<< "REFLECTIONS: " << std::boolalpha << m_IsReflecting << std::endl
+		<< "--------\n";
+
+	OnSettingChanged();
+}
+
+void Renderer::ToggleWavefront()
+{
+	m_IsWavefront = !m_IsWavefront;
+	system("CLS");
+	std::cout
+		<< CONTROLS
+		<< "--------\n"
+		<< "WAVEFRONT RENDERING: " << std::boolalpha << m_IsWavefront << std::endl
+		<< "--------\n";
+
+	OnSettingChanged();
+}
+
+void Renderer::CycleSampler()
+{
+	m_SamplerType = SamplerType((int(m_SamplerType) + 1) % int(SamplerType::AMOUNT));
+	system("CLS");
+	std::cout
+		<< CONTROLS
+		<< "--------\n"
+		<< "SAMPLER: " << (m_SamplerType == SamplerType::sobol ? "Owen Scrambled Sobol" : "Random") << std::endl
+		<< "--------\n";
+
+	OnSettingChanged();
+}
+
+void Renderer::ToggleSkippingUnchangedFrames()
+{
+	m_IsSkippingUnchangedFrames = !m_IsSkippingUnchangedFrames;
+	system("CLS");
+	std::cout
+		<< CONTROLS
+		<< "--------\n"
+		<< "SKIPPING UNCHANGED FRAMES: " << std::boolalpha << m_IsSkippingUnchangedFrames << std::endl
+		<< "--------\n";
+
+	OnSettingChanged();
+}
+
+void Renderer::ToggleInteractivePreview()
+{
+	m_IsPreviewing = !m_IsPreviewing;
+	system("CLS");
+	std::cout
+		<< CONTROLS
+		<< "--------\n"
+		<< "INTERACTIVE PREVIEW: " << std::boolalpha << m_IsPreviewing << std::endl
+		<< "--------\n";
+
+	OnSettingChanged();
 }
 
-#ifdef REFLECT
 void Renderer::IncrementReflectionBounceAmount(int incrementer)
 {
 	m_ReflectionBounceAmount = std::max(m_ReflectionBounceAmount + incrementer, 1);
@@ -253,6 +1352,5 @@ void Renderer::IncrementReflectionBounceAmount(int incrementer)
 		<< "REFLECTIONS BOUNCE AMOUNT: " << m_ReflectionBounceAmount << std::endl
 		<< "--------\n";
 
-	ResetAccumulatedReflectionData();
-}
-#endif
\ No newline at end of file
+	OnSettingChanged();
+}
\ No newline at end of file
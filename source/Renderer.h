@@ -1,18 +1,26 @@
-//#define REFLECT
-
 #pragma once
 
 #include <vector>
+#include <future>
 
 #include "SDL.h"
 #include "ColorRGB.hpp"
+#include "DataTypes.hpp"
+#include "Sampler.hpp"
+#include "ThreadPool.h"
+#include "Camera.h"
 
 class Scene;
+class Material;
 
 class Renderer final
 {
 public:
-	Renderer(SDL_Window* const pWindow, const Scene* const pScene);
+	static constexpr int DEFAULT_TILE_SIZE{ 32 };
+	static constexpr float DEFAULT_TARGET_FRAME_TIME{ 1.0f / 60.0f };
+
+	//	Zero threads uses every hardware thread, the tile size gets rounded up to whole ray packets
+	Renderer(SDL_Window* const pWindow, const Scene* const pScene, int threadAmount = 0, int tileSize = DEFAULT_TILE_SIZE);
 	~Renderer() = default;
 
 	Renderer(const Renderer&) = delete;
@@ -20,50 +28,318 @@ public:
 	Renderer& operator=(const Renderer&) = delete;
 	Renderer& operator=(Renderer&&) noexcept = delete;
 
+	//	Renders a frame and presents it
 	void Render();
+
+	//	Pipelined rendering: BeginRender traces the frame on another thread while the caller presents the previous frame
+	//	and updates the next scene. Nothing else may change the renderer or its scene until EndRender returns.
+	//	Only the tiles that changed since the last present get pushed to the window, Present returns whether there were any
+	void BeginRender();
+	void EndRender();
+	bool Present();
+
+	//	The next present pushes the whole last frame again, e.g. after the window got exposed
+	inline void InvalidateWindow()
+	{
+		m_IsPresentingFullFrame = true;
+	}
+
+	//	Returns whether the frame finished within the timeout, so the caller can keep sampling input meanwhile.
+	//	A skipped frame counts as finished once the timeout passed, which keeps an idle loop from spinning
+	bool WaitForRender(int timeoutMilliseconds) const;
+
+	//	Only between frames
+	inline void SetScene(const Scene* const pScene)
+	{
+		m_pScene = pScene;
+	}
+
+	//	Without a latch the camera of the scene gets used
+	inline void SetCameraLatch(const CameraLatch* const pCameraLatch)
+	{
+		m_pCameraLatch = pCameraLatch;
+	}
+
+	//	In seconds, picks the resolution of the interactive preview
+	inline void SetTargetFrameTime(float targetFrameTime)
+	{
+		m_TargetFrameTime = targetFrameTime;
+	}
+
+	//	Of the last presented frame, in seconds
+	inline float GetInputLatency() const
+	{
+		return m_InputLatency;
+	}
+
 	bool SaveBufferToImage() const;
 
 	void CycleLightingMode();
 	void ToggleShadows();
-#ifdef REFLECT
+	void ToggleReflections();
 	void IncrementReflectionBounceAmount(int incrementer);
+	void CycleSampler();
+	void ToggleWavefront();
+	void ToggleSkippingUnchangedFrames();
+	void ToggleInteractivePreview();
 
+	//	Only does work while reflecting, the accumulation gets cleared when reflections get turned on
 	inline void ResetAccumulatedReflectionData()
 	{
-		m_FrameIndex = 1;
+		if (!m_IsReflecting)
+			return;
+
+		m_vTileFrameIndices.assign(m_vTileFrameIndices.size(), 1);
 		m_vAccumulatedReflectionData.assign(m_Width * m_Height, ColorRGB(0.0f, 0.0f, 0.0f));
 	}
-#endif
 
 private:
+	enum class LightingMode
+	{
+		observedArea,
+		radiance,
+		BRDF,
+		combined,
+
+		AMOUNT
+	};
+
+	//	Every combination of lighting mode, shadows and reflections gets its own instantiation of the render loops,
+	//	so none of them get branched on per light. The kernel gets picked once per frame
+	using RenderKernel = void (Renderer::*)(const Camera& camera);
+
+	RenderKernel GetRenderKernel() const;
+	template<LightingMode LIGHTING_MODE>
+	RenderKernel GetRenderKernel() const;
+
+	//	Runs on the render thread: latches the camera right before the frame gets traced, so the dirty tiles, the preview scale and
+	//	the accumulation all get settled for the camera the kernel traces with
+	void RenderFrame(RenderKernel renderKernel);
+	Camera LatchCamera();
+
+	//	Screen-space dirty regions: while the camera and the settings stay the same, only the tiles that the old and new bounds of
+	//	the objects that changed can cover get traced, together with the shadows those bounds cast. Nothing dirty skips the frame,
+	//	except while reflections accumulate
+	void UpdateDirtyTiles(const Camera& camera);
+	void MarkDirtyTiles(const AABB& bounds, const Matrix& worldToCamera, const std::vector<Light>& vLights);
+	void MarkAllTilesDirty();
+	void ResetDirtyTileAccumulation();
+	void OnSettingChanged();
+
+	//	Interactive preview: while the camera moves the packet renderer only traces every second or fourth pixel in both directions,
+	//	the coarsest that fits the target frame time. Once it stops, every frame halves the spacing and only traces the new pixels
+	void UpdatePreviewScale(bool isCameraMoving, bool didNothingChange);
+	void UpsamplePreview(int tileIndex);
+
+	//	Converts colors that went through MaxToOne into buffer pixels a register width at a time, the window surface has
+	//	eight bits per channel
+	void WritePixels(const ColorRGB* pColors, int firstPixelIndex, int amount);
+	template<InstructionSet INSTRUCTION_SET>
+	void WritePixels(const ColorRGB* pColors, int firstPixelIndex, int amount);
+
+	template<LightingMode LIGHTING_MODE, bool CAST_SHADOWS, bool IS_REFLECTING>
+	void RenderPackets(const Camera& camera);
+	template<LightingMode LIGHTING_MODE, bool CAST_SHADOWS, bool IS_REFLECTING>
+	void RenderWavefront(const Camera& camera);
+
+	template<LightingMode LIGHTING_MODE, bool IS_REFLECTING>
+	ColorRGB GetLightContribution(const Material& material, const SurfacePoint& surfacePoint, const Light& light, const Vector3& lightDirection, const Vector3& viewDirection) const;
+
 	SDL_Window* const m_pWindow;
 	SDL_Surface* const m_pBuffer;
 	uint32_t* m_pBufferPixels;
 
-	const Scene* const m_pScene;
+	//	The frame being rendered and the last finished one, which gets copied into the window surface when presenting
+	std::vector<uint32_t>
+		m_vRenderPixels,
+		m_vPresentPixels;
+
+	const Scene* m_pScene;
+
+	const CameraLatch* m_pCameraLatch;
+
+	//	Performance counter of the input sample the frame being rendered and the last finished frame latched
+	uint64_t
+		m_RenderInputTime,
+		m_PresentInputTime;
+
+	float m_InputLatency;
+
+	//	Picked once at startup, gates the AVX paths
+	const InstructionSet m_InstructionSet;
 
 	int
 		m_Width,
 		m_Height;
 
-	enum class LightingMode
+	LightingMode m_LightingMode;
+
+	bool
+		m_CastShadows,
+		m_IsReflecting;
+
+	//	The packet renderer splits the screen into square tiles that the workers of the pool take in Morton order
+	struct Tile
 	{
-		observedArea,
-		radiance,
-		BRDF,
-		combined,
+		int
+			x,
+			y;
+	};
 
-		AMOUNT
-	} m_LightingMode;
+	ThreadPool m_ThreadPool;
+	const int m_TileSize;
+	int m_TileAmountX;
+	std::vector<Tile> m_vTiles;
 
-	bool m_CastShadows;
+	//	Per tile data is stored row by row rather than in the order of m_vTiles
+	inline int GetTileGridIndex(int pixelX, int pixelY) const
+	{
+		return pixelY / m_TileSize * m_TileAmountX + pixelX / m_TileSize;
+	}
 
-	std::vector<float> m_PixelsY;
+	inline SDL_Rect GetTileRect(const Tile& tile) const
+	{
+		return SDL_Rect{ tile.x, tile.y, std::min(m_TileSize, m_Width - tile.x), std::min(m_TileSize, m_Height - tile.y) };
+	}
 
-#ifdef REFLECT
 	int m_ReflectionBounceAmount;
 
+	//	Picks the jitter of the reflection bounces, keyed by pixel, accumulated frame and bounce
+	SamplerType m_SamplerType;
+
+	//	Every tile counts its own accumulated frames, so only the tiles that changed start over
 	std::vector<ColorRGB> m_vAccumulatedReflectionData;
-	int m_FrameIndex;
-#endif
+	std::vector<int> m_vTileFrameIndices;
+
+	//	Wavefront rendering runs every stage over all paths that are still bouncing before moving on to the next stage,
+	//	instead of following one path at a time
+	bool m_IsWavefront;
+
+	//	One entry per path that is still bouncing, with every attribute in its own array
+	struct PathQueue
+	{
+		std::vector<int> vPixelIndices;
+
+		std::vector<Vector3>
+			vOrigins,
+			vDirections;
+
+		std::vector<float> vColorFragmentsLeftToUse;
+		std::vector<HitRecord> vHitRecords;
+		std::vector<SurfacePoint> vSurfacePoints;
+		std::vector<unsigned char> vAreAlive;
+
+		inline int GetSize() const
+		{
+			return static_cast<int>(vPixelIndices.size());
+		}
+
+		inline void Resize(int size)
+		{
+			vPixelIndices.resize(size);
+			vOrigins.resize(size);
+			vDirections.resize(size);
+			vColorFragmentsLeftToUse.resize(size);
+			vHitRecords.resize(size);
+			vSurfacePoints.resize(size);
+			vAreAlive.resize(size);
+		}
+
+		//	The attributes a path carries from one bounce to the next
+		inline void SwapBouncingAttributes(PathQueue& queue)
+		{
+			vPixelIndices.swap(queue.vPixelIndices);
+			vOrigins.swap(queue.vOrigins);
+			vDirections.swap(queue.vDirections);
+			vColorFragmentsLeftToUse.swap(queue.vColorFragmentsLeftToUse);
+		}
+	}
+		m_PathQueue,
+		m_BouncingPathQueue;
+
+	//	The stages hand the pool chunks of consecutive paths, whole ray packets so the primary rays keep their packets
+	static constexpr int PATH_CHUNK_SIZE{ 16 * RayPacket::SIZE };
+
+	//	Calls function with the first and the end path of every chunk
+	template<typename Function>
+	void RunPathChunks(int pathAmount, const Function& function);
+
+	//	The paths that hit something grouped by material, where every material starts and where every chunk puts its paths
+	//	of every material, and where every chunk puts its paths that keep bouncing
+	std::vector<int>
+		m_vSortedPathIndices,
+		m_vMaterialOffsets,
+		m_vChunkMaterialOffsets,
+		m_vChunkBouncingPathOffsets;
+
+	//	One shadow ray per path and light
+	std::vector<Ray> m_vShadowRays;
+	std::vector<unsigned char> m_vAreShadowRaysOccluded;
+
+	std::vector<ColorRGB> m_vFrameColors;
+
+	bool
+		m_IsSkippingUnchangedFrames,
+		m_AreSettingsChanged,
+		m_IsSkippingFrame;
+
+	//	Of the camera the last rendered frame latched
+	Matrix m_RenderedCameraToWorld;
+	float m_RenderedFieldOfViewValue;
+
+	//	The bounded objects as the last rendered frame saw them, spheres followed by triangle meshes.
+	//	Spheres only fill in their bounds, they get compared as a whole
+	struct ObjectState
+	{
+		bool operator==(const ObjectState& objectState) const = default;
+
+		AABB bounds;
+		Matrix transform;
+
+		unsigned char materialIndex;
+		Triangle::CullMode cullMode;
+		uint64_t geometryFingerprint;
+	};
+
+	std::vector<ObjectState>
+		m_vRenderedObjects,
+		m_vObjects;
+
+	std::vector<Sphere> m_vRenderedSpheres;
+	std::vector<Plane> m_vRenderedPlanes;
+	std::vector<Light> m_vRenderedLights;
+
+	//	Materials are immutable and only get added, so their amount tells whether they changed
+	int m_RenderedMaterialAmount;
+
+	static constexpr int MAXIMAL_PREVIEW_SCALE{ 4 };
+
+	bool
+		m_IsPreviewing,
+		m_IsReusingSamples;
+
+	//	Pixel spacing of the frame being rendered and of the last rendered one
+	int
+		m_PreviewScale,
+		m_ImageScale;
+
+	float
+		m_TargetFrameTime,
+		m_TracedPixelTime;
+
+	//	The traced pixels of the preview, the hit distance keeps the upsampling from blending across silhouettes
+	std::vector<ColorRGB> m_vPreviewColors;
+	std::vector<float> m_vPreviewDepths;
+
+	//	Row by row, and the indices into m_vTiles of the tiles that get traced
+	std::vector<unsigned char> m_vAreTilesDirty;
+	std::vector<int> m_vDirtyTileIndices;
+	bool m_IsFullFrame;
+
+	//	What changed in the present pixels since the last present
+	std::vector<SDL_Rect> m_vPresentRects;
+	bool m_IsPresentingFullFrame;
+
+	//	Declared last so an unfinished frame gets waited for before anything it uses is destroyed
+	std::future<void> m_RenderFuture;
 };
\ No newline at end of file
@@ -0,0 +1,24 @@
+#pragma once
+
+//	Backs Vector3, Vector4 and Matrix with SSE and enables the eight lane AVX types of the batched paths.
+//	The ScalarMath configuration defines SCALAR_MATH to build with the scalar reference implementations instead
+#ifndef SCALAR_MATH
+#define SIMD_MATH
+#endif
+
+#ifdef SIMD_MATH
+#include <immintrin.h>
+
+//	Reciprocal square root estimate refined by one Newton-Raphson step, close to full float precision
+inline __m128 GetReciprocalSquareRoot(__m128 value)
+{
+	const __m128 estimate{ _mm_rsqrt_ps(value) };
+	return _mm_mul_ps(_mm_mul_ps(_mm_set1_ps(0.5f), estimate), _mm_sub_ps(_mm_set1_ps(3.0f), _mm_mul_ps(_mm_mul_ps(value, estimate), estimate)));
+}
+
+inline __m256 GetReciprocalSquareRoot(__m256 value)
+{
+	const __m256 estimate{ _mm256_rsqrt_ps(value) };
+	return _mm256_mul_ps(_mm256_mul_ps(_mm256_set1_ps(0.5f), estimate), _mm256_sub_ps(_mm256_set1_ps(3.0f), _mm256_mul_ps(_mm256_mul_ps(value, estimate), estimate)));
+}
+#endif
\ No newline at end of file
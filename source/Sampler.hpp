@@ -0,0 +1,161 @@
+#pragma once
+
+#include <cstdint>
+
+#include "Vector3.hpp"
+
+enum class SamplerType
+{
+	random,
+	sobol,
+
+	AMOUNT
+};
+
+//	The PCG hash from Jarzynski and Olano, one step of the PCG generator with its output permutation
+inline uint32_t GetPCGHash(uint32_t input)
+{
+	const uint32_t
+		state{ input * 747796405u + 2891336453u },
+		word{ ((state >> ((state >> 28u) + 4u)) ^ state) * 277803737u };
+
+	return (word >> 22u) ^ word;
+}
+
+inline uint32_t GetReversedBits(uint32_t value)
+{
+	value = (value << 16) | (value >> 16);
+	value = ((value & 0x00ff00ffu) << 8) | ((value & 0xff00ff00u) >> 8);
+	value = ((value & 0x0f0f0f0fu) << 4) | ((value & 0xf0f0f0f0u) >> 4);
+	value = ((value & 0x33333333u) << 2) | ((value & 0xccccccccu) >> 2);
+	value = ((value & 0x55555555u) << 1) | ((value & 0xaaaaaaaau) >> 1);
+	return value;
+}
+
+//	Maps the upper 24 bits to [0, 1)
+inline float GetUnitFloat(uint32_t value)
+{
+	return (value >> 8) * (1.0f / 16777216.0f);
+}
+
+//	Direction numbers of the first Sobol dimensions, dimension 0 is the van der Corput sequence and the others come from
+//	the primitive polynomials x + 1 and x^2 + x + 1 with the initial numbers of Joe and Kuo
+struct SobolDirections
+{
+	static constexpr int
+		DIMENSION_AMOUNT{ 3 },
+		BIT_AMOUNT{ 32 };
+
+	constexpr SobolDirections() :
+		aDirections{}
+	{
+		constexpr int
+			aDegrees[DIMENSION_AMOUNT]{ 1, 1, 2 },
+			aCoefficients[DIMENSION_AMOUNT]{ 0, 0, 1 },
+			aInitialNumbers[DIMENSION_AMOUNT][2]{ { 1 }, { 1 }, { 1, 3 } };
+
+		for (int dimension{}; dimension < DIMENSION_AMOUNT; ++dimension)
+		{
+			const int degree{ aDegrees[dimension] };
+			for (int bit{}; bit < BIT_AMOUNT; ++bit)
+			{
+				if (dimension == 0)
+					aDirections[dimension][bit] = 1u << (31 - bit);
+				else if (bit < degree)
+					aDirections[dimension][bit] = uint32_t(aInitialNumbers[dimension][bit]) << (31 - bit);
+				else
+				{
+					uint32_t direction{ aDirections[dimension][bit - degree] ^ (aDirections[dimension][bit - degree] >> degree) };
+					for (int term{ 1 }; term < degree; ++term)
+						if ((aCoefficients[dimension] >> (degree - 1 - term)) & 1)
+							direction ^= aDirections[dimension][bit - term];
+
+					aDirections[dimension][bit] = direction;
+				}
+			}
+		}
+	}
+
+	uint32_t aDirections[DIMENSION_AMOUNT][BIT_AMOUNT];
+};
+
+static constexpr SobolDirections SOBOL_DIRECTIONS{};
+
+inline uint32_t GetSobol(uint32_t index, int dimension)
+{
+	uint32_t value{};
+	for (int bit{}; index; index >>= 1, ++bit)
+		if (index & 1)
+			value ^= SOBOL_DIRECTIONS.aDirections[dimension][bit];
+
+	return value;
+}
+
+//	Owen scrambling with the hash based permutation of Laine and Karras, as described by Burley,
+//	every bit gets flipped depending only on the bits above it
+inline uint32_t GetOwenScrambled(uint32_t value, uint32_t seed)
+{
+	value = GetReversedBits(value);
+
+	value += seed;
+	value ^= value * 0x6c50b47cu;
+	value ^= value * 0xb82f1e52u;
+	value ^= value * 0xc7afe638u;
+	value ^= value * 0x8d22f6e6u;
+
+	return GetReversedBits(value);
+}
+
+//	Counter based sampling: every value is a pure function of the pixel, the sample index and the bounce,
+//	so no state gets shared between threads and the image doesn't depend on how the work got scheduled
+struct Sampler
+{
+public:
+	Sampler(SamplerType type, int pixelIndex, int sampleIndex) :
+		type{ type },
+		pixelSeed{ GetPCGHash(static_cast<uint32_t>(pixelIndex)) },
+		sampleIndex{ static_cast<uint32_t>(sampleIndex) }
+	{
+	}
+
+	//	A point in [0, 1)^3, every bounce gets its own sequence
+	inline Vector3 GetVector3(int bounce) const
+	{
+		const uint32_t bounceSeed{ GetPCGHash(pixelSeed + static_cast<uint32_t>(bounce)) };
+
+		float aComponents[SobolDirections::DIMENSION_AMOUNT];
+		if (type == SamplerType::sobol)
+		{
+			//	The scrambled index shuffles the order of the samples per pixel and bounce, so neighbouring pixels and bounces stay uncorrelated
+			const uint32_t shuffledIndex{ GetOwenScrambled(sampleIndex, bounceSeed) };
+			for (int dimension{}; dimension < SobolDirections::DIMENSION_AMOUNT; ++dimension)
+				aComponents[dimension] = GetUnitFloat(GetOwenScrambled(GetSobol(shuffledIndex, dimension), GetPCGHash(bounceSeed + dimension + 1)));
+		}
+		else
+		{
+			const uint32_t sampleSeed{ GetPCGHash(bounceSeed ^ GetPCGHash(sampleIndex)) };
+			for (int dimension{}; dimension < SobolDirections::DIMENSION_AMOUNT; ++dimension)
+				aComponents[dimension] = GetUnitFloat(GetPCGHash(sampleSeed + dimension));
+		}
+
+		return Vector3(aComponents[0], aComponents[1], aComponents[2]);
+	}
+
+	//	Every component in [minimalComponentsValue, maximalComponentsValue), the counterpart of Vector3::GetRandom
+	inline Vector3 GetVector3(int bounce, float minimalComponentsValue, float maximalComponentsValue) const
+	{
+		const Vector3 sample{ GetVector3(bounce) };
+		return Vector3
+		(
+			minimalComponentsValue + sample.x * (maximalComponentsValue - minimalComponentsValue),
+			minimalComponentsValue + sample.y * (maximalComponentsValue - minimalComponentsValue),
+			minimalComponentsValue + sample.z * (maximalComponentsValue - minimalComponentsValue)
+		);
+	}
+
+	SamplerType type;
+
+	uint32_t
+		pixelSeed,
+		sampleIndex;
+};
\ No newline at end of file
@@ -12,7 +12,18 @@ Scene::Scene(const std::string& sceneName, const Camera& camera) :
 
 	m_vSpheres{},
 	m_vPlanes{},
-	m_vTriangleMeshes{}
+	m_vTriangleMeshes{},
+
+	m_TopLevelBVH{},
+	m_vObjectBounds{},
+	m_vNewObjectBounds{},
+	m_TopLevelBVHBuildSurfaceAreaSum{},
+
+	m_WideSpheres{},
+	m_WidePlanes{},
+
+	m_vBuiltSpheres{},
+	m_vBuiltPlanes{}
 {
 	m_vpMaterials.reserve(32);
 	m_vLights.reserve(32);
@@ -30,38 +41,208 @@ Scene::~Scene()
 
 void Scene::Update(const Timer& timer)
 {
-	m_Camera.Update(timer);
+	UpdateObjects(timer);
+
+	//	Objects can also change through the pointers the Add functions return, so the changes get found by comparing the objects
+	//	with the ones the acceleration structures were built from. Those of static scenes stay as they are
+	const bool didBoundsChange{ UpdateObjectBounds() };
+	if (didBoundsChange)
+		UpdateTopLevelBVH();
+
+	if (didBoundsChange || m_vSpheres != m_vBuiltSpheres)
+	{
+		m_WideSpheres.Build(m_vSpheres, m_TopLevelBVH.GetPrimitiveIndices());
+		m_vBuiltSpheres = m_vSpheres;
+	}
+
+	if (m_vPlanes != m_vBuiltPlanes)
+	{
+		m_WidePlanes.Build(m_vPlanes);
+		m_vBuiltPlanes = m_vPlanes;
+	}
 }
 
 void Scene::GetClosestHit(const Ray& ray, HitRecord& closestHit) const
 {
-	for (const Sphere& sphere : m_vSpheres)
-		HitTestSphere(sphere, ray, closestHit);
-
-	for (const Plane& plane : m_vPlanes)
-		HitTestPlane(plane, ray, closestHit);
+	if (HitTestPlanes(m_WidePlanes, ray, closestHit))
+		closestHit.objectIndex = m_TopLevelBVH.GetPrimitiveAmount() + closestHit.primitiveIndex;
 
-	for (const TriangleMesh& triangleMesh : m_vTriangleMeshes)
-		HitTestTriangleMesh(triangleMesh, ray, closestHit);
+	HitTestBVHLeaves(m_TopLevelBVH, ray, closestHit,
+		[this](int firstIndex, int objectAmount, const Ray& ray, HitRecord& hitRecord)
+		{
+			return HitTestObjects(firstIndex, objectAmount, ray, hitRecord);
+		});
 }
 
 bool Scene::DoesHit(const Ray& ray) const
 {
-	for (const Sphere& sphere : m_vSpheres)
-		if (HitTestSphere(sphere, ray))
-			return true;
+	if (HitTestPlanes(m_WidePlanes, ray))
+		return true;
 
-	for (const Plane& plane : m_vPlanes)
-		if (HitTestPlane(plane, ray))
-			return true;
+	return HitTestBVHLeaves(m_TopLevelBVH, ray,
+		[this](int firstIndex, int objectAmount, const Ray& ray)
+		{
+			return HitTestObjects(firstIndex, objectAmount, ray);
+		});
+}
 
-	for (const TriangleMesh& triangleMesh : m_vTriangleMeshes)
-		if (HitTestTriangleMesh(triangleMesh, ray))
+void Scene::GetClosestHit(const RayPacket& packet, HitRecord aClosestHits[RayPacket::SIZE]) const
+{
+	RayPacket shrinkingPacket{ packet };
+	for (int mask{ packet.activeMask }; mask; mask &= mask - 1)
+	{
+		const int lane{ std::countr_zero(static_cast<unsigned int>(mask)) };
+		if (HitTestPlanes(m_WidePlanes, packet.GetRay(lane), aClosestHits[lane]))
+			aClosestHits[lane].objectIndex = m_TopLevelBVH.GetPrimitiveAmount() + aClosestHits[lane].primitiveIndex;
+
+		shrinkingPacket.aMax[lane] = std::min(packet.aMax[lane], aClosestHits[lane].t);
+	}
+
+	HitTestBVHLeaves<false>(m_TopLevelBVH, shrinkingPacket,
+		[this, &shrinkingPacket, aClosestHits](int firstIndex, int objectAmount, int laneMask)
+		{
+			HitTestObjects(firstIndex, objectAmount, shrinkingPacket, laneMask, aClosestHits);
+		});
+}
+
+int Scene::DoesHit(const RayPacket& packet) const
+{
+	RayPacket remainingPacket{ packet };
+	for (int mask{ packet.activeMask }; mask; mask &= mask - 1)
+	{
+		const int lane{ std::countr_zero(static_cast<unsigned int>(mask)) };
+		if (HitTestPlanes(m_WidePlanes, packet.GetRay(lane)))
+			remainingPacket.activeMask &= ~(1 << lane);
+	}
+
+	HitTestBVHLeaves<true>(m_TopLevelBVH, remainingPacket,
+		[this, &remainingPacket](int firstIndex, int objectAmount, int laneMask)
+		{
+			remainingPacket.activeMask &= ~HitTestObjects(firstIndex, objectAmount, remainingPacket, laneMask & remainingPacket.activeMask);
+		});
+
+	return packet.activeMask & ~remainingPacket.activeMask;
+}
+
+SurfacePoint Scene::GetSurfacePoint(const Ray& ray, const HitRecord& hitRecord) const
+{
+	const int
+		sphereAmount{ static_cast<int>(m_vSpheres.size()) },
+		boundedObjectAmount{ sphereAmount + static_cast<int>(m_vTriangleMeshes.size()) };
+
+	SurfacePoint surfacePoint;
+	surfacePoint.origin = ray.origin + hitRecord.t * ray.direction;
+
+	if (hitRecord.objectIndex < sphereAmount)
+	{
+		const Sphere& sphere{ m_vSpheres[hitRecord.objectIndex] };
+		surfacePoint.normal = (surfacePoint.origin - sphere.origin) / sphere.radius;
+		surfacePoint.materialIndex = sphere.materialIndex;
+	}
+	else if (hitRecord.objectIndex < boundedObjectAmount)
+	{
+		const TriangleMesh& triangleMesh{ m_vTriangleMeshes[hitRecord.objectIndex - sphereAmount] };
+		surfacePoint.normal = GetTriangleMeshNormal(triangleMesh, hitRecord.primitiveIndex, ray);
+		surfacePoint.materialIndex = triangleMesh.materialIndex;
+	}
+	else
+	{
+		const Plane& plane{ m_vPlanes[hitRecord.objectIndex - boundedObjectAmount] };
+		surfacePoint.normal = plane.normal;
+		surfacePoint.materialIndex = plane.materialIndex;
+	}
+
+	return surfacePoint;
+}
+
+void Scene::UpdateObjects([[maybe_unused]] const Timer& timer)
+{
+}
+
+bool Scene::HitTestObjects(int firstIndex, int objectAmount, const Ray& ray, HitRecord& hitRecord) const
+{
+	const std::vector<int>& vObjectIndices{ m_TopLevelBVH.GetPrimitiveIndices() };
+	const int sphereAmount{ static_cast<int>(m_vSpheres.size()) };
+
+	bool didHit{};
+	if (sphereAmount && HitTestSpheres(m_WideSpheres, firstIndex, objectAmount, ray, hitRecord))
+	{
+		hitRecord.objectIndex = vObjectIndices[hitRecord.primitiveIndex];
+		didHit = true;
+	}
+
+	for (int index{ firstIndex }; index < firstIndex + objectAmount; ++index)
+		if (vObjectIndices[index] >= sphereAmount && HitTestTriangleMesh(m_vTriangleMeshes[vObjectIndices[index] - sphereAmount], ray, hitRecord))
+		{
+			hitRecord.objectIndex = vObjectIndices[index];
+			didHit = true;
+		}
+
+	return didHit;
+}
+
+bool Scene::HitTestObjects(int firstIndex, int objectAmount, const Ray& ray) const
+{
+	const std::vector<int>& vObjectIndices{ m_TopLevelBVH.GetPrimitiveIndices() };
+	const int sphereAmount{ static_cast<int>(m_vSpheres.size()) };
+
+	if (sphereAmount && HitTestSpheres(m_WideSpheres, firstIndex, objectAmount, ray))
+		return true;
+
+	for (int index{ firstIndex }; index < firstIndex + objectAmount; ++index)
+		if (vObjectIndices[index] >= sphereAmount && HitTestTriangleMesh(m_vTriangleMeshes[vObjectIndices[index] - sphereAmount], ray))
 			return true;
 
 	return false;
 }
 
+void Scene::HitTestObjects(int firstIndex, int objectAmount, RayPacket& packet, int laneMask, HitRecord aHitRecords[RayPacket::SIZE]) const
+{
+	const std::vector<int>& vObjectIndices{ m_TopLevelBVH.GetPrimitiveIndices() };
+	const int sphereAmount{ static_cast<int>(m_vSpheres.size()) };
+
+	if (sphereAmount)
+		for (int mask{ laneMask }; mask; mask &= mask - 1)
+		{
+			const int lane{ std::countr_zero(static_cast<unsigned int>(mask)) };
+			if (HitTestSpheres(m_WideSpheres, firstIndex, objectAmount, packet.GetRay(lane), aHitRecords[lane]))
+			{
+				aHitRecords[lane].objectIndex = vObjectIndices[aHitRecords[lane].primitiveIndex];
+				packet.aMax[lane] = aHitRecords[lane].t;
+			}
+		}
+
+	for (int index{ firstIndex }; index < firstIndex + objectAmount; ++index)
+	{
+		if (vObjectIndices[index] < sphereAmount)
+			continue;
+
+		for (int mask{ HitTestTriangleMesh(m_vTriangleMeshes[vObjectIndices[index] - sphereAmount], packet, laneMask, aHitRecords) }; mask; mask &= mask - 1)
+			aHitRecords[std::countr_zero(static_cast<unsigned int>(mask))].objectIndex = vObjectIndices[index];
+	}
+}
+
+int Scene::HitTestObjects(int firstIndex, int objectAmount, const RayPacket& packet, int laneMask) const
+{
+	const std::vector<int>& vObjectIndices{ m_TopLevelBVH.GetPrimitiveIndices() };
+	const int sphereAmount{ static_cast<int>(m_vSpheres.size()) };
+
+	int occludedMask{};
+	if (sphereAmount)
+		for (int mask{ laneMask }; mask; mask &= mask - 1)
+		{
+			const int lane{ std::countr_zero(static_cast<unsigned int>(mask)) };
+			if (HitTestSpheres(m_WideSpheres, firstIndex, objectAmount, packet.GetRay(lane)))
+				occludedMask |= 1 << lane;
+		}
+
+	for (int index{ firstIndex }; index < firstIndex + objectAmount && laneMask & ~occludedMask; ++index)
+		if (vObjectIndices[index] >= sphereAmount)
+			occludedMask |= HitTestTriangleMesh(m_vTriangleMeshes[vObjectIndices[index] - sphereAmount], packet, laneMask & ~occludedMask);
+
+	return occludedMask;
+}
+
 unsigned char Scene::AddMaterial(Material* pMaterial)
 {
 	m_vpMaterials.push_back(pMaterial);
@@ -92,6 +273,41 @@ TriangleMesh* const Scene::AddTriangleMesh(const TriangleMesh& triangleMesh)
 	return &m_vTriangleMeshes.back();
 }
 
+bool Scene::UpdateObjectBounds()
+{
+	m_vNewObjectBounds.clear();
+	for (const Sphere& sphere : m_vSpheres)
+	{
+		const Vector3 radius{ sphere.radius, sphere.radius, sphere.radius };
+		m_vNewObjectBounds.push_back(AABB(sphere.origin - radius, sphere.origin + radius));
+	}
+
+	for (const TriangleMesh& triangleMesh : m_vTriangleMeshes)
+		m_vNewObjectBounds.push_back(AABB(triangleMesh.smallestAABBTransformed, triangleMesh.largestAABBTransformed));
+
+	if (m_vNewObjectBounds == m_vObjectBounds)
+		return false;
+
+	m_vObjectBounds.swap(m_vNewObjectBounds);
+	return true;
+}
+
+//	Refits the top level whenever bounds changed, and only rebuilds it once objects got added or refitting degraded it too much
+void Scene::UpdateTopLevelBVH()
+{
+	static constexpr float MAX_REFIT_SURFACE_AREA_SUM_GROWTH{ 1.5f };
+
+	if (m_TopLevelBVH.GetPrimitiveAmount() == m_vObjectBounds.size())
+	{
+		m_TopLevelBVH.Refit(m_vObjectBounds);
+		if (m_TopLevelBVH.GetSurfaceAreaSum() <= MAX_REFIT_SURFACE_AREA_SUM_GROWTH * m_TopLevelBVHBuildSurfaceAreaSum)
+			return;
+	}
+
+	m_TopLevelBVH.Build(m_vObjectBounds);
+	m_TopLevelBVHBuildSurfaceAreaSum = m_TopLevelBVH.GetSurfaceAreaSum();
+}
+
 SceneWeek1::SceneWeek1() :
 	Scene("Week 1")
 {
@@ -219,6 +435,7 @@ SceneWeek4::SceneWeek4() :
 
 		TriangleMesh* const pTriangleMesh{ AddTriangleMesh(TriangleMesh(lambertWhite, cullMode)) };
 		pTriangleMesh->AppendTriangle(baseTriangle);
+		pTriangleMesh->FinishAppending();
 		pTriangleMesh->SetTranslator(Vector3(-1.75f, 4.5f, 0.0f) + float(index) * offset);
 		pTriangleMesh->UpdateTransforms();
 		m_apTriangleMeshes[index] = pTriangleMesh;
@@ -229,10 +446,8 @@ SceneWeek4::SceneWeek4() :
 	AddLight(Light(Vector3(2.5f, 2.5f, -5.0f), 50.0f, ColorRGB(0.34f, 0.47f, 0.68f)));
 }
 
-void SceneWeek4::Update(const Timer& timer)
+void SceneWeek4::UpdateObjects(const Timer& timer)
 {
-	Scene::Update(timer);
-
 	const float yawAngle{ (cos(timer.GetTotal()) + 1.0f) / 2.0f * DOUBLE_PI };
 
 	for (TriangleMesh* const pTriangleMesh : m_apTriangleMeshes)
@@ -267,10 +482,8 @@ SceneWeek4Bunny::SceneWeek4Bunny() :
 	AddLight(Light(Vector3(2.5f, 2.5f, -5.0f), 50.0f, ColorRGB(0.34f, 0.47f, 0.68f)));
 }
 
-void SceneWeek4Bunny::Update(const Timer& timer)
+void SceneWeek4Bunny::UpdateObjects(const Timer& timer)
 {
-	Scene::Update(timer);
-
 	const float yawAngle{ (cos(timer.GetTotal()) + 1.0f) / 2.0f * DOUBLE_PI };
 	m_pBunnyTriangleMesh->SetRotorY(yawAngle);
 	m_pBunnyTriangleMesh->UpdateTransforms();
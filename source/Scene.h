@@ -17,10 +17,19 @@ public:
 	Scene& operator=(const Scene&) = delete;
 	Scene& operator=(Scene&&) noexcept = delete;
 
-	virtual void Update(const Timer& timer);
+	//	Updates the objects, the camera follows the input separately
+	void Update(const Timer& timer);
+
 	void GetClosestHit(const Ray& ray, HitRecord& closestHit) const;
 	bool DoesHit(const Ray& ray) const;
 
+	//	Packet versions for the active lanes, DoesHit returns the mask of the occluded lanes
+	void GetClosestHit(const RayPacket& packet, HitRecord aClosestHits[RayPacket::SIZE]) const;
+	int DoesHit(const RayPacket& packet) const;
+
+	//	Builds the surface attributes of a hit that GetClosestHit found along the ray
+	SurfacePoint GetSurfacePoint(const Ray& ray, const HitRecord& hitRecord) const;
+
 	inline const Camera& GetCamera() const
 	{
 		return m_Camera;
@@ -57,6 +66,8 @@ public:
 	}
 
 protected:
+	virtual void UpdateObjects(const Timer& timer);
+
 	unsigned char AddMaterial(Material* pMaterial);
 	Light* const AddLight(const Light& light);
 
@@ -65,6 +76,15 @@ protected:
 	TriangleMesh* const AddTriangleMesh(const TriangleMesh& triangleMesh);
 
 private:
+	//	Test the objects of a top level leaf, firstIndex and objectAmount describe the leaf range in top level primitive order
+	bool HitTestObjects(int firstIndex, int objectAmount, const Ray& ray, HitRecord& hitRecord) const;
+	bool HitTestObjects(int firstIndex, int objectAmount, const Ray& ray) const;
+	void HitTestObjects(int firstIndex, int objectAmount, RayPacket& packet, int laneMask, HitRecord aHitRecords[RayPacket::SIZE]) const;
+	int HitTestObjects(int firstIndex, int objectAmount, const RayPacket& packet, int laneMask) const;
+	//	Returns whether any bounds changed
+	bool UpdateObjectBounds();
+	void UpdateTopLevelBVH();
+
 	std::string	m_SceneName;
 
 	Camera m_Camera;
@@ -74,6 +94,22 @@ private:
 	std::vector<Sphere> m_vSpheres;
 	std::vector<Plane> m_vPlanes;
 	std::vector<TriangleMesh> m_vTriangleMeshes;
+
+	//	Spheres followed by triangle meshes, planes are unbounded and therefore tested separately. Hit records index the objects
+	//	in the same order, with the planes after the triangle meshes
+	BVH m_TopLevelBVH;
+	std::vector<AABB>
+		m_vObjectBounds,
+		m_vNewObjectBounds;
+	float m_TopLevelBVHBuildSurfaceAreaSum;
+
+	//	Rebuilt every update from the spheres and planes above, the spheres in top level primitive order
+	WideSpheres m_WideSpheres;
+	WidePlanes m_WidePlanes;
+
+	//	The spheres and planes the wide layouts were built from
+	std::vector<Sphere> m_vBuiltSpheres;
+	std::vector<Plane> m_vBuiltPlanes;
 };
 
 class SceneWeek1 final : public Scene
@@ -123,9 +159,9 @@ public:
 	SceneWeek4& operator=(const SceneWeek4&) = delete;
 	SceneWeek4& operator=(SceneWeek4&&) noexcept = delete;
 
-	virtual void Update(const Timer& timer) override;
-
 private:
+	virtual void UpdateObjects(const Timer& timer) override;
+
 	TriangleMesh* m_apTriangleMeshes[3];
 };
 
@@ -140,9 +176,9 @@ public:
 	SceneWeek4Bunny& operator=(const SceneWeek4Bunny&) = delete;
 	SceneWeek4Bunny& operator=(SceneWeek4Bunny&&) noexcept = delete;
 
-	virtual void Update(const Timer& timer) override;
-
 private:
+	virtual void UpdateObjects(const Timer& timer) override;
+
 	TriangleMesh* m_pBunnyTriangleMesh;
 };
 
@@ -0,0 +1,241 @@
+#include "ThreadPool.h"
+
+#include <algorithm>
+
+#ifdef _WIN32
+#define NOMINMAX
+#include <Windows.h>
+#else
+#include <pthread.h>
+#endif
+
+//	The logical processors in the affinity mask of the process, empty when it can't be queried
+static std::vector<int> GetAllowedProcessors()
+{
+	std::vector<int> vProcessors{};
+#ifdef _WIN32
+	DWORD_PTR processMask, systemMask;
+	if (GetProcessAffinityMask(GetCurrentProcess(), &processMask, &systemMask))
+		for (int processor{}; processor < 64; ++processor)
+			if ((processMask >> processor) & 1)
+				vProcessors.push_back(processor);
+#else
+	cpu_set_t processors;
+	CPU_ZERO(&processors);
+	if (!sched_getaffinity(0, sizeof(processors), &processors))
+		for (int processor{}; processor < CPU_SETSIZE; ++processor)
+			if (CPU_ISSET(processor, &processors))
+				vProcessors.push_back(processor);
+#endif
+	return vProcessors;
+}
+
+static void PinThread(std::thread& thread, int processor)
+{
+#ifdef _WIN32
+	SetThreadAffinityMask(thread.native_handle(), DWORD_PTR(1) << processor);
+#else
+	cpu_set_t processors;
+	CPU_ZERO(&processors);
+	CPU_SET(processor, &processors);
+	pthread_setaffinity_np(thread.native_handle(), sizeof(processors), &processors);
+#endif
+}
+
+ThreadPool::ThreadPool(int threadAmount) :
+	m_vAllowedProcessors{ GetAllowedProcessors() },
+	m_ThreadAmount
+	{
+		std::max(threadAmount > 0 ? threadAmount :
+			m_vAllowedProcessors.empty() ? static_cast<int>(std::thread::hardware_concurrency()) : static_cast<int>(m_vAllowedProcessors.size()), 1)
+	},
+
+	m_MainWorker{},
+	m_vWorkers{},
+	m_vWorkQueues(m_ThreadAmount),
+
+	m_MainJob{},
+	m_pTask{},
+	m_RemainingTaskAmount{},
+
+	m_JobIndex{},
+	m_ActiveWorkerAmount{},
+	m_IsStopping{ false }
+{
+	m_MainWorker = std::thread(&ThreadPool::MainWorkerLoop, this);
+	for (int workerIndex{ 1 }; workerIndex < m_ThreadAmount; ++workerIndex)
+		m_vWorkers.emplace_back(&ThreadPool::WorkerLoop, this, workerIndex);
+
+	//	Pinned to one allowed logical processor each, so the tiles a worker renders keep using the same caches.
+	//	With more workers than processors the scheduler spreads them instead
+	if (m_ThreadAmount <= static_cast<int>(m_vAllowedProcessors.size()))
+	{
+		PinThread(m_MainWorker, m_vAllowedProcessors[0]);
+		for (int workerIndex{ 1 }; workerIndex < m_ThreadAmount; ++workerIndex)
+			PinThread(m_vWorkers[workerIndex - 1], m_vAllowedProcessors[workerIndex]);
+	}
+}
+
+ThreadPool::~ThreadPool()
+{
+	{
+		const std::lock_guard lock{ m_Mutex };
+		m_IsStopping = true;
+	}
+
+	m_MainJobAvailable.notify_one();
+	m_WorkAvailable.notify_all();
+
+	m_MainWorker.join();
+	for (std::thread& worker : m_vWorkers)
+		worker.join();
+}
+
+std::future<void> ThreadPool::RunAsync(const std::function<void()>& job)
+{
+	std::future<void> future;
+	{
+		const std::lock_guard lock{ m_Mutex };
+		m_MainJob = std::packaged_task<void()>(job);
+		future = m_MainJob.get_future();
+	}
+
+	m_MainJobAvailable.notify_one();
+	return future;
+}
+
+void ThreadPool::Run(int taskAmount, const std::function<void(int)>& task)
+{
+	if (taskAmount <= 0)
+		return;
+
+	{
+		//	A worker still looking for tasks of the last job could steal into its queue right after it got refilled here,
+		//	which would drop the tasks it got
+		std::unique_lock lock{ m_Mutex };
+		m_WorkFinished.wait(lock, [this]() { return m_ActiveWorkerAmount == 0; });
+
+		m_pTask = &task;
+		m_RemainingTaskAmount = taskAmount;
+
+		//	Every worker starts with an equal share of consecutive tasks
+		for (int workerIndex{}; workerIndex < m_ThreadAmount; ++workerIndex)
+		{
+			WorkQueue& queue{ m_vWorkQueues[workerIndex] };
+			const std::lock_guard queueLock{ queue.mutex };
+			queue.first = static_cast<int>(int64_t(taskAmount) * workerIndex / m_ThreadAmount);
+			queue.end = static_cast<int>(int64_t(taskAmount) * (workerIndex + 1) / m_ThreadAmount);
+		}
+
+		++m_JobIndex;
+	}
+
+	m_WorkAvailable.notify_all();
+	ProcessTasks(0);
+
+	std::unique_lock lock{ m_Mutex };
+	m_WorkFinished.wait(lock, [this]() { return m_RemainingTaskAmount == 0; });
+	m_pTask = nullptr;
+}
+
+void ThreadPool::MainWorkerLoop()
+{
+	while (true)
+	{
+		std::packaged_task<void()> job;
+		{
+			std::unique_lock lock{ m_Mutex };
+			m_MainJobAvailable.wait(lock, [this]() { return m_IsStopping || m_MainJob.valid(); });
+			if (m_IsStopping)
+				return;
+
+			job = std::move(m_MainJob);
+		}
+
+		job();
+	}
+}
+
+void ThreadPool::WorkerLoop(int workerIndex)
+{
+	uint64_t jobIndex{};
+	while (true)
+	{
+		{
+			std::unique_lock lock{ m_Mutex };
+			m_WorkAvailable.wait(lock, [this, jobIndex]() { return m_IsStopping || m_JobIndex != jobIndex; });
+			if (m_IsStopping)
+				return;
+
+			jobIndex = m_JobIndex;
+			++m_ActiveWorkerAmount;
+		}
+
+		ProcessTasks(workerIndex);
+
+		{
+			const std::lock_guard lock{ m_Mutex };
+			--m_ActiveWorkerAmount;
+		}
+
+		m_WorkFinished.notify_one();
+	}
+}
+
+void ThreadPool::ProcessTasks(int workerIndex)
+{
+	int task;
+	while (PopTask(workerIndex, task) || (StealTasks(workerIndex) && PopTask(workerIndex, task)))
+	{
+		(*m_pTask)(task);
+
+		//	The last task wakes up Run, the lock makes sure it is already waiting or will see the count
+		if (--m_RemainingTaskAmount == 0)
+		{
+			{
+				const std::lock_guard lock{ m_Mutex };
+			}
+
+			m_WorkFinished.notify_one();
+		}
+	}
+}
+
+bool ThreadPool::PopTask(int workerIndex, int& task)
+{
+	WorkQueue& queue{ m_vWorkQueues[workerIndex] };
+	const std::lock_guard lock{ queue.mutex };
+	if (queue.first == queue.end)
+		return false;
+
+	task = queue.first++;
+	return true;
+}
+
+bool ThreadPool::StealTasks(int workerIndex)
+{
+	for (int offset{ 1 }; offset < m_ThreadAmount; ++offset)
+	{
+		WorkQueue& victimQueue{ m_vWorkQueues[(workerIndex + offset) % m_ThreadAmount] };
+
+		int first, end;
+		{
+			const std::lock_guard lock{ victimQueue.mutex };
+			const int remainingTaskAmount{ victimQueue.end - victimQueue.first };
+			if (!remainingTaskAmount)
+				continue;
+
+			end = victimQueue.end;
+			first = end - (remainingTaskAmount + 1) / 2;
+			victimQueue.end = first;
+		}
+
+		WorkQueue& queue{ m_vWorkQueues[workerIndex] };
+		const std::lock_guard lock{ queue.mutex };
+		queue.first = first;
+		queue.end = end;
+		return true;
+	}
+
+	return false;
+}
\ No newline at end of file
@@ -0,0 +1,75 @@
+#pragma once
+
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <functional>
+#include <future>
+
+//	Persistent worker threads that get woken up for every job instead of being dispatched again every frame.
+//	Every worker owns a range of the task indices and takes tasks from its front, a worker that runs out steals the back half
+//	of the range of another worker, so consecutive tasks mostly end up on the same thread
+class ThreadPool final
+{
+public:
+	//	Zero uses every logical processor the process may run on, the thread calling Run counts as one of them
+	explicit ThreadPool(int threadAmount = 0);
+	~ThreadPool();
+
+	ThreadPool(const ThreadPool&) = delete;
+	ThreadPool(ThreadPool&&) noexcept = delete;
+	ThreadPool& operator=(const ThreadPool&) = delete;
+	ThreadPool& operator=(ThreadPool&&) noexcept = delete;
+
+	//	Calls task for every index in [0, taskAmount) and returns once all of them finished
+	void Run(int taskAmount, const std::function<void(int)>& task);
+
+	//	Runs the job on worker 0, a persistent thread that gets pinned like the others, so the jobs calling Run from it
+	//	keep their caches as well. One job at a time
+	std::future<void> RunAsync(const std::function<void()>& job);
+
+	inline int GetThreadAmount() const
+	{
+		return m_ThreadAmount;
+	}
+
+private:
+	//	A deque of task indices, which can be a range because tasks never get pushed while a job runs
+	struct alignas(64) WorkQueue
+	{
+		std::mutex mutex;
+
+		int
+			first,
+			end;
+	};
+
+	void MainWorkerLoop();
+	void WorkerLoop(int workerIndex);
+	void ProcessTasks(int workerIndex);
+	bool PopTask(int workerIndex, int& task);
+	bool StealTasks(int workerIndex);
+
+	const std::vector<int> m_vAllowedProcessors;
+	const int m_ThreadAmount;
+
+	std::thread m_MainWorker;
+	std::vector<std::thread> m_vWorkers;
+	std::vector<WorkQueue> m_vWorkQueues;
+
+	std::packaged_task<void()> m_MainJob;
+	const std::function<void(int)>* m_pTask;
+	std::atomic<int> m_RemainingTaskAmount;
+
+	std::mutex m_Mutex;
+	std::condition_variable
+		m_MainJobAvailable,
+		m_WorkAvailable,
+		m_WorkFinished;
+
+	uint64_t m_JobIndex;
+	int m_ActiveWorkerAmount;
+	bool m_IsStopping;
+};
\ No newline at end of file
@@ -6,6 +6,7 @@
 
 #include "SDL.h"
 #include "Constants.hpp"
+#include "InstructionSet.hpp"
 
 Timer::Timer()
 {
@@ -64,6 +65,11 @@ void Timer::StartBenchmark(int numFrames)
 	m_Benchmarks.clear();
 	m_Benchmarks.resize(m_BenchmarkFrames);
 
+	m_BenchmarkLatencyHigh = 0.f;
+	m_BenchmarkLatencyAvg = 0.f;
+	m_BenchmarkLatencies.clear();
+	m_BenchmarkLatencies.resize(m_BenchmarkFrames);
+
 	system("CLS");
 	std::cout
 		<< CONTROLS
@@ -108,9 +114,17 @@ void Timer::Update()
 		m_FPSCount = 0;
 		m_FPSTimer = 0.0f;
 
+		m_InputLatency = m_InputLatencyCount ? m_InputLatencySum / m_InputLatencyCount : 0.0f;
+		m_MaxInputLatency = m_CurrentMaxInputLatency;
+		m_InputLatencySum = 0.0f;
+		m_CurrentMaxInputLatency = 0.0f;
+		m_InputLatencyCount = 0;
+
 		if (m_BenchmarkActive)
 		{
 			m_Benchmarks[m_BenchmarkCurrFrame] = m_dFPS;
+			m_BenchmarkLatencies[m_BenchmarkCurrFrame] = m_InputLatency;
+			m_BenchmarkLatencyHigh = std::max(m_BenchmarkLatencyHigh, m_MaxInputLatency);
 
 			m_BenchmarkLow = std::min(m_BenchmarkLow, m_dFPS);
 			m_BenchmarkHigh = std::max(m_BenchmarkHigh, m_dFPS);
@@ -120,6 +134,7 @@ void Timer::Update()
 			{
 				m_BenchmarkActive = false;
 				m_BenchmarkAvg = std::accumulate(m_Benchmarks.begin(), m_Benchmarks.end(), 0.f) / float(m_BenchmarkFrames);
+				m_BenchmarkLatencyAvg = std::accumulate(m_BenchmarkLatencies.begin(), m_BenchmarkLatencies.end(), 0.f) / float(m_BenchmarkFrames);
 
 				//print
 				system("CLS");
@@ -127,23 +142,36 @@ void Timer::Update()
 					<< CONTROLS
 					<< "--------\n"
 					<< "BENCHMARK FINISHED\n"
+					<< ">> INSTRUCTION SET = " << GetInstructionSetName(GetInstructionSet()) << std::endl
 					<< ">> HIGH = " << m_BenchmarkHigh << std::endl
 					<< ">> LOW = " << m_BenchmarkLow << std::endl
 					<< ">> AVG = " << m_BenchmarkAvg << std::endl
+					<< ">> AVG INPUT LATENCY = " << m_BenchmarkLatencyAvg * 1000.0f << " ms" << std::endl
+					<< ">> MAX INPUT LATENCY = " << m_BenchmarkLatencyHigh * 1000.0f << " ms" << std::endl
 					<< "--------\n";
 
 				//file save
 				std::ofstream fileStream("benchmark.txt");
+				fileStream << "INSTRUCTION SET = " << GetInstructionSetName(GetInstructionSet()) << std::endl;
 				fileStream << "FRAMES = " << m_BenchmarkCurrFrame << std::endl;
 				fileStream << "HIGH = " << m_BenchmarkHigh << std::endl;
 				fileStream << "LOW = " << m_BenchmarkLow << std::endl;
 				fileStream << "AVG = " << m_BenchmarkAvg << std::endl;
+				fileStream << "AVG INPUT LATENCY = " << m_BenchmarkLatencyAvg * 1000.0f << " ms" << std::endl;
+				fileStream << "MAX INPUT LATENCY = " << m_BenchmarkLatencyHigh * 1000.0f << " ms" << std::endl;
 				fileStream.close();
 			}
 		}
 	}
 }
 
+void Timer::AddInputLatency(float latency)
+{
+	m_InputLatencySum += latency;
+	m_CurrentMaxInputLatency = std::max(m_CurrentMaxInputLatency, latency);
+	++m_InputLatencyCount;
+}
+
 void Timer::Stop()
 {
 	if (!m_IsStopped)
@@ -40,6 +40,19 @@ public:
 		return m_TotalTime;
 	}
 
+	//	The time from sampling the input a presented frame used until it was presented, averaged per second like the FPS
+	void AddInputLatency(float latency);
+
+	inline float GetInputLatency() const
+	{
+		return m_InputLatency;
+	}
+
+	inline float GetMaxInputLatency() const
+	{
+		return m_MaxInputLatency;
+	}
+
 	inline bool IsRunning() const
 	{ 
 		return !m_IsStopped;
@@ -62,6 +75,12 @@ private:
 	float m_ElapsedUpperBound = 0.03f;
 	float m_FPSTimer = 0.0f;
 
+	float m_InputLatency = 0.0f;
+	float m_MaxInputLatency = 0.0f;
+	float m_InputLatencySum = 0.0f;
+	float m_CurrentMaxInputLatency = 0.0f;
+	uint32_t m_InputLatencyCount = 0;
+
 	bool m_IsStopped = true;
 	bool m_ForceElapsedUpperBound = false;
 
@@ -72,4 +91,7 @@ private:
 	int m_BenchmarkFrames{ 0 };
 	int m_BenchmarkCurrFrame{ 0 };
 	std::vector<float> m_Benchmarks{};
+	float m_BenchmarkLatencyHigh{ 0.f };
+	float m_BenchmarkLatencyAvg{ 0.f };
+	std::vector<float> m_BenchmarkLatencies{};
 };
\ No newline at end of file
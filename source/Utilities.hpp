@@ -1,8 +1,12 @@
 #pragma once
 
 #include <float.h>
+#include <bit>
+#include <type_traits>
+#include <immintrin.h>
 
 #include "DataTypes.hpp"
+#include "InstructionSet.hpp"
 
 template<typename Type>
 inline Type Square(const Type& a)
@@ -22,7 +26,7 @@ inline bool AreEqual(float a, float b, float epsilon = FLT_EPSILON)
 }
 
 //#define SPHERE_HIT_TEST_GEOMETRIC
-inline bool HitTestSphere(const Sphere& sphere, const Ray& ray, HitRecord& hitRecord, bool ignoreHitRecord = false)
+inline bool GetSphereHitDistance(const Sphere& sphere, const Ray& ray, float& t)
 {
 #ifdef SPHERE_HIT_TEST_GEOMETRIC
 	const Vector3 L{ sphere.origin - ray.origin };
@@ -38,7 +42,7 @@ inline bool HitTestSphere(const Sphere& sphere, const Ray& ray, HitRecord& hitRe
 
 	const float thc{ sqrtf(sphereRadiusSquared - odSquared) };
 
-	float t{ tca - thc };
+	t = tca - thc;
 	if (t < ray.min)
 		t = tca + thc;
 #else
@@ -55,35 +59,51 @@ inline bool HitTestSphere(const Sphere& sphere, const Ray& ray, HitRecord& hitRe
 
 	const float squareRootedDiscriminant{ sqrtf(discriminant) };
 
-	float t{ (-b - squareRootedDiscriminant) };
+	t = -b - squareRootedDiscriminant;
 	if (t < ray.min)
-		t = (-b + squareRootedDiscriminant);
+		t = -b + squareRootedDiscriminant;
 #endif
 	if (t < ray.min || t > ray.max)
 		return false;
 
+	return true;
+}
+
+inline void SetHitRecord(int primitiveIndex, float t, float u, float v, HitRecord& hitRecord)
+{
+	hitRecord.t = t;
+	hitRecord.u = u;
+	hitRecord.v = v;
+
+	hitRecord.primitiveIndex = primitiveIndex;
+	hitRecord.didHit = true;
+}
+
+inline bool HitTestSphere(const Sphere& sphere, const Ray& ray, HitRecord& hitRecord, bool ignoreHitRecord = false)
+{
+	float t;
+	if (!GetSphereHitDistance(sphere, ray, t))
+		return false;
+
 	if (ignoreHitRecord)
 		return true;
 
+	//	Only records t, the caller knows which sphere it tested
 	if (t < hitRecord.t)
 	{
 		hitRecord.t = t;
-
-		hitRecord.origin = ray.origin + hitRecord.t * ray.direction;
-		hitRecord.normal = (hitRecord.origin - sphere.origin) / sphere.radius;
-
 		hitRecord.didHit = true;
-		hitRecord.materialIndex = sphere.materialIndex;
 		return true;
 	}
 
 	return false;
 }
 
+//	Occlusion test for shadow rays
 inline bool HitTestSphere(const Sphere& sphere, const Ray& ray)
 {
-	HitRecord temporary;
-	return HitTestSphere(sphere, ray, temporary, true);
+	float t;
+	return GetSphereHitDistance(sphere, ray, t);
 }
 
 inline bool HitTestPlane(const Plane& plane, const Ray& ray, HitRecord& hitRecord, bool ignoreHitRecord = false)
@@ -96,46 +116,244 @@ inline bool HitTestPlane(const Plane& plane, const Ray& ray, HitRecord& hitRecor
 	if (ignoreHitRecord)
 		return true;
 
+	//	Only records t, the caller knows which plane it tested
 	if (t < hitRecord.t)
 	{
 		hitRecord.t = t;
-
-		hitRecord.origin = ray.origin + hitRecord.t * ray.direction;
-		hitRecord.normal = plane.normal;
-
 		hitRecord.didHit = true;
-		hitRecord.materialIndex = plane.materialIndex;
 		return true;
 	}
 
 	return false;
 }
 
+//	Occlusion test for shadow rays
 inline bool HitTestPlane(const Plane& plane, const Ray& ray)
 {
-	HitRecord temporary;
-	return HitTestPlane(plane, ray, temporary, true);
+	const float t{ Vector3::Dot(plane.origin - ray.origin, plane.normal) / Vector3::Dot(ray.direction, plane.normal) };
+	if (t < ray.min || t > ray.max)
+		return false;
+
+	return true;
+}
+
+//	The lane with the smallest t out of hitMask, the lowest lane wins ties like testing the primitives one by one would
+template<typename LANES = FloatLanes<InstructionSet::SSE>>
+inline int GetNearestLane(int hitMask, typename LANES::Type t)
+{
+	float aT[LANES::WIDTH];
+	LANES::Store(aT, t);
+
+	int nearestLane{ std::countr_zero(static_cast<unsigned int>(hitMask)) };
+	for (hitMask &= hitMask - 1; hitMask; hitMask &= hitMask - 1)
+	{
+		const int lane{ std::countr_zero(static_cast<unsigned int>(hitMask)) };
+		if (aT[lane] < aT[nearestLane])
+			nearestLane = lane;
+	}
+
+	return nearestLane;
+}
+
+template<typename LANES = FloatLanes<InstructionSet::SSE>>
+inline float GetLane(typename LANES::Type value, int lane)
+{
+	float aValues[LANES::WIDTH];
+	LANES::Store(aValues, value);
+	return aValues[lane];
+}
+
+//	GetSphereHitDistance for a register width of spheres starting at index, laneMask selects the lanes to test. Returns the mask of the hit lanes
+template<typename LANES = FloatLanes<InstructionSet::SSE>>
+inline int GetSphereHitDistances(const WideSpheres& spheres, int index, int laneMask, const Ray& ray, typename LANES::Type& t)
+{
+	using Type = typename LANES::Type;
+
+	const Type
+		deltaOriginX{ LANES::Subtract(LANES::Set(ray.origin.x), LANES::Load(spheres.GetComponent(WideSpheres::originX, index))) },
+		deltaOriginY{ LANES::Subtract(LANES::Set(ray.origin.y), LANES::Load(spheres.GetComponent(WideSpheres::originY, index))) },
+		deltaOriginZ{ LANES::Subtract(LANES::Set(ray.origin.z), LANES::Load(spheres.GetComponent(WideSpheres::originZ, index))) },
+		b{ LANES::Add(LANES::Add(
+			LANES::Multiply(LANES::Set(ray.direction.x), deltaOriginX),
+			LANES::Multiply(LANES::Set(ray.direction.y), deltaOriginY)),
+			LANES::Multiply(LANES::Set(ray.direction.z), deltaOriginZ)) },
+		c{ LANES::Subtract(
+			LANES::Add(LANES::Add(LANES::Multiply(deltaOriginX, deltaOriginX), LANES::Multiply(deltaOriginY, deltaOriginY)), LANES::Multiply(deltaOriginZ, deltaOriginZ)),
+			LANES::Load(spheres.GetComponent(WideSpheres::radiusSquared, index))) },
+		discriminant{ LANES::Subtract(LANES::Multiply(b, b), c) };
+
+	const int mask{ laneMask & LANES::GetGreaterMask(discriminant, LANES::Set(0.0f)) };
+	if (!mask)
+		return 0;
+
+	const Type
+		rayMin{ LANES::Set(ray.min) },
+		squareRootedDiscriminant{ LANES::GetSquareRoot(discriminant) },
+		negatedB{ LANES::Subtract(LANES::Set(-0.0f), b) },
+		tNear{ LANES::Subtract(negatedB, squareRootedDiscriminant) };
+
+	t = LANES::SelectLess(tNear, rayMin, LANES::Add(negatedB, squareRootedDiscriminant), tNear);
+	return mask & LANES::GetGreaterEqualMask(t, rayMin) & LANES::GetLessEqualMask(t, LANES::Set(ray.max));
+}
+
+//	Tests the spheres of a range a register width at a time and records the slot of the closest one, the slots of other objects in the range never hit
+template<InstructionSet INSTRUCTION_SET>
+inline bool HitTestSpheres(const WideSpheres& spheres, int firstIndex, int amount, const Ray& ray, HitRecord& hitRecord)
+{
+	using Lanes = FloatLanes<INSTRUCTION_SET>;
+
+	const int endIndex{ firstIndex + amount };
+
+	bool didHit{};
+	for (int index{ firstIndex }; index < endIndex; index += Lanes::WIDTH)
+	{
+		typename Lanes::Type t;
+		int hitMask{ GetSphereHitDistances<Lanes>(spheres, index, (1 << std::min(endIndex - index, Lanes::WIDTH)) - 1, ray, t) };
+		hitMask &= Lanes::GetLessMask(t, Lanes::Set(hitRecord.t));
+		if (!hitMask)
+			continue;
+
+		const int nearestLane{ GetNearestLane<Lanes>(hitMask, t) };
+		SetHitRecord(index + nearestLane, GetLane<Lanes>(t, nearestLane), 0.0f, 0.0f, hitRecord);
+		didHit = true;
+	}
+
+	return didHit;
+}
+
+//	Occlusion test for shadow rays
+template<InstructionSet INSTRUCTION_SET>
+inline bool HitTestSpheres(const WideSpheres& spheres, int firstIndex, int amount, const Ray& ray)
+{
+	using Lanes = FloatLanes<INSTRUCTION_SET>;
+
+	const int endIndex{ firstIndex + amount };
+	for (int index{ firstIndex }; index < endIndex; index += Lanes::WIDTH)
+	{
+		typename Lanes::Type t;
+		if (GetSphereHitDistances<Lanes>(spheres, index, (1 << std::min(endIndex - index, Lanes::WIDTH)) - 1, ray, t))
+			return true;
+	}
+
+	return false;
 }
 
-inline bool SlabTestTriangleMesh(const TriangleMesh& triangleMesh, const Ray& ray)
+//	Plane distances for a register width of planes starting at index, laneMask selects the lanes to test. Returns the mask of the hit lanes
+template<typename LANES = FloatLanes<InstructionSet::SSE>>
+inline int GetPlaneHitDistances(const WidePlanes& planes, int index, int laneMask, const Ray& ray, typename LANES::Type& t)
+{
+	using Type = typename LANES::Type;
+
+	const Type
+		normalX{ LANES::Load(planes.GetComponent(WidePlanes::normalX, index)) },
+		normalY{ LANES::Load(planes.GetComponent(WidePlanes::normalY, index)) },
+		normalZ{ LANES::Load(planes.GetComponent(WidePlanes::normalZ, index)) },
+		dotRayOriginNormal{ LANES::Add(LANES::Add(
+			LANES::Multiply(LANES::Set(ray.origin.x), normalX),
+			LANES::Multiply(LANES::Set(ray.origin.y), normalY)),
+			LANES::Multiply(LANES::Set(ray.origin.z), normalZ)) },
+		dotRayDirectionNormal{ LANES::Add(LANES::Add(
+			LANES::Multiply(LANES::Set(ray.direction.x), normalX),
+			LANES::Multiply(LANES::Set(ray.direction.y), normalY)),
+			LANES::Multiply(LANES::Set(ray.direction.z), normalZ)) };
+
+	t = LANES::Divide(LANES::Subtract(LANES::Load(planes.GetComponent(WidePlanes::originDotNormal, index)), dotRayOriginNormal), dotRayDirectionNormal);
+	return laneMask & LANES::GetGreaterEqualMask(t, LANES::Set(ray.min)) & LANES::GetLessEqualMask(t, LANES::Set(ray.max));
+}
+
+template<InstructionSet INSTRUCTION_SET>
+inline bool HitTestPlanes(const WidePlanes& planes, const Ray& ray, HitRecord& hitRecord)
+{
+	using Lanes = FloatLanes<INSTRUCTION_SET>;
+
+	bool didHit{};
+	for (int index{}; index < planes.amount; index += Lanes::WIDTH)
+	{
+		typename Lanes::Type t;
+		int hitMask{ GetPlaneHitDistances<Lanes>(planes, index, (1 << std::min(planes.amount - index, Lanes::WIDTH)) - 1, ray, t) };
+		hitMask &= Lanes::GetLessMask(t, Lanes::Set(hitRecord.t));
+		if (!hitMask)
+			continue;
+
+		const int nearestLane{ GetNearestLane<Lanes>(hitMask, t) };
+		SetHitRecord(index + nearestLane, GetLane<Lanes>(t, nearestLane), 0.0f, 0.0f, hitRecord);
+		didHit = true;
+	}
+
+	return didHit;
+}
+
+//	Occlusion test for shadow rays
+template<InstructionSet INSTRUCTION_SET>
+inline bool HitTestPlanes(const WidePlanes& planes, const Ray& ray)
+{
+	using Lanes = FloatLanes<INSTRUCTION_SET>;
+
+	for (int index{}; index < planes.amount; index += Lanes::WIDTH)
+	{
+		typename Lanes::Type t;
+		if (GetPlaneHitDistances<Lanes>(planes, index, (1 << std::min(planes.amount - index, Lanes::WIDTH)) - 1, ray, t))
+			return true;
+	}
+
+	return false;
+}
+
+//	The sphere and plane tests with the instruction set picked at startup
+inline bool HitTestSpheres(const WideSpheres& spheres, int firstIndex, int amount, const Ray& ray, HitRecord& hitRecord)
+{
+	return DispatchInstructionSet(GetInstructionSet(),
+		[&spheres, firstIndex, amount, &ray, &hitRecord](auto instructionSet)
+		{
+			return HitTestSpheres<decltype(instructionSet)::value>(spheres, firstIndex, amount, ray, hitRecord);
+		});
+}
+
+inline bool HitTestSpheres(const WideSpheres& spheres, int firstIndex, int amount, const Ray& ray)
+{
+	return DispatchInstructionSet(GetInstructionSet(),
+		[&spheres, firstIndex, amount, &ray](auto instructionSet)
+		{
+			return HitTestSpheres<decltype(instructionSet)::value>(spheres, firstIndex, amount, ray);
+		});
+}
+
+inline bool HitTestPlanes(const WidePlanes& planes, const Ray& ray, HitRecord& hitRecord)
+{
+	return DispatchInstructionSet(GetInstructionSet(),
+		[&planes, &ray, &hitRecord](auto instructionSet)
+		{
+			return HitTestPlanes<decltype(instructionSet)::value>(planes, ray, hitRecord);
+		});
+}
+
+inline bool HitTestPlanes(const WidePlanes& planes, const Ray& ray)
+{
+	return DispatchInstructionSet(GetInstructionSet(),
+		[&planes, &ray](auto instructionSet)
+		{
+			return HitTestPlanes<decltype(instructionSet)::value>(planes, ray);
+		});
+}
+
+inline bool SlabTest(const AABB& aabb, const Ray& ray, const Vector3& inverseRayDirection, float& tEntry, float& tExit)
 {
 	const Vector3
-		& smallestAABBTransformed{ triangleMesh.smallestAABBTransformed },
-		& largestAABBTransformed{ triangleMesh.largestAABBTransformed },
-		& rayOrigin{ ray.origin },
-		& rayDirection{ ray.direction };
+		& smallestAABB{ aabb.smallest },
+		& largestAABB{ aabb.largest },
+		& rayOrigin{ ray.origin };
 
 	const float
-		tx1{ (smallestAABBTransformed.x - rayOrigin.x) / rayDirection.x },
-		tx2{ (largestAABBTransformed.x - rayOrigin.x) / rayDirection.x },
+		tx1{ (smallestAABB.x - rayOrigin.x) * inverseRayDirection.x },
+		tx2{ (largestAABB.x - rayOrigin.x) * inverseRayDirection.x },
 
-		tyl{ (smallestAABBTransformed.y - rayOrigin.y) / rayDirection.y },
-		ty2{ (largestAABBTransformed.y - rayOrigin.y) / rayDirection.y },
+		tyl{ (smallestAABB.y - rayOrigin.y) * inverseRayDirection.y },
+		ty2{ (largestAABB.y - rayOrigin.y) * inverseRayDirection.y },
 
-		tzl{ (smallestAABBTransformed.z - rayOrigin.z) / rayDirection.z },
-		tz2{ (largestAABBTransformed.z - rayOrigin.z) / rayDirection.z };
+		tzl{ (smallestAABB.z - rayOrigin.z) * inverseRayDirection.z },
+		tz2{ (largestAABB.z - rayOrigin.z) * inverseRayDirection.z };
 
-	float 
+	float
 		tMin{ std::min(tx1, tx2) },
 		tMax{ std::max(tx1, tx2) };
 
@@ -145,118 +363,1121 @@ inline bool SlabTestTriangleMesh(const TriangleMesh& triangleMesh, const Ray& ra
 	tMin = std::max(tMin, std::min(tzl, tz2));
 	tMax = std::min(tMax, std::max(tzl, tz2));
 
-	return tMax > 0 && tMax >= tMin;
+	tEntry = tMin;
+	tExit = tMax;
+	return tMax >= tMin && tMax >= ray.min && tMin <= ray.max;
 }
 
-inline bool HitTestTriangle(const Triangle& triangle, const Ray& ray, HitRecord& hitRecord, bool ignoreHitRecord = false)
+inline bool SlabTest(const AABB& aabb, const Ray& ray, const Vector3& inverseRayDirection, float& tEntry)
 {
-	const Vector3
-		& normal{ triangle.normal },
-		& rayDirection{ ray.direction };
+	float tExit;
+	return SlabTest(aabb, ray, inverseRayDirection, tEntry, tExit);
+}
 
-	const float dotNormalRayDirection{ Vector3::Dot(normal, ignoreHitRecord ? -rayDirection : rayDirection) };
+inline Vector3 GetInverseDirection(const Vector3& direction)
+{
+	return Vector3(1.0f / direction.x, 1.0f / direction.y, 1.0f / direction.z);
+}
 
-	switch (triangle.cullMode)
+//	Calls function with the cull mode as a std::integral_constant, so the triangle tests below get instantiated per cull mode
+//	instead of switching on it for every triangle
+template<typename Function>
+inline auto DispatchCullMode(Triangle::CullMode cullMode, Function function)
+{
+	switch (cullMode)
 	{
 	case Triangle::CullMode::frontFace:
-		if (dotNormalRayDirection <= 0.0f)
-			return false;
-		break;
+		return function(std::integral_constant<Triangle::CullMode, Triangle::CullMode::frontFace>());
 
 	case Triangle::CullMode::backFace:
-		if (dotNormalRayDirection >= 0.0f)
-			return false;
-		break;
+		return function(std::integral_constant<Triangle::CullMode, Triangle::CullMode::backFace>());
 
-	case Triangle::CullMode::none:
-		if (AreEqual(dotNormalRayDirection, 0.0f))
+	default:
+		return function(std::integral_constant<Triangle::CullMode, Triangle::CullMode::none>());
+	}
+}
+
+//	Moller-Trumbore intersection with the culling of the original plane test, returns the barycentrics of v1 and v2 in u and v
+//	Shadow rays point away from the surface, so they cull the opposite faces
+template<Triangle::CullMode CULL_MODE, bool IS_SHADOW_RAY>
+inline bool GetTriangleHitDistance(const PrecomputedTriangle& triangle, const Ray& ray, float& t, float& u, float& v)
+{
+	const float dotNormalRayDirection{ Vector3::Dot(triangle.normal, IS_SHADOW_RAY ? -ray.direction : ray.direction) };
+
+	if constexpr (CULL_MODE == Triangle::CullMode::frontFace)
+	{
+		if (dotNormalRayDirection <= 0.0f)
 			return false;
-		break;
 	}
+	else if constexpr (CULL_MODE == Triangle::CullMode::backFace)
+	{
+		if (dotNormalRayDirection >= 0.0f)
+			return false;
+	}
+	else if (AreEqual(dotNormalRayDirection, 0.0f))
+		return false;
 
 	const Vector3
-		& v0{ triangle.v0 },
-		& v1{ triangle.v1 },
-		& v2{ triangle.v2 },
-		& rayOrigin{ ray.origin },
-		L{ v0 - rayOrigin };
+		p{ Vector3::Cross(ray.direction, triangle.edge2) },
+		s{ ray.origin - triangle.v0 },
+		q{ Vector3::Cross(s, triangle.edge1) };
 
-	const float
-		dotRayDirectionNormal{ Vector3::Dot(rayDirection, normal) },
-		t{ Vector3::Dot(L, normal) / dotRayDirectionNormal };
-	if (t < ray.min || t > ray.max)
+	const float inverseDeterminant{ 1.0f / Vector3::Dot(triangle.edge1, p) };
+
+	u = Vector3::Dot(s, p) * inverseDeterminant;
+	v = Vector3::Dot(ray.direction, q) * inverseDeterminant;
+	t = Vector3::Dot(triangle.edge2, q) * inverseDeterminant;
+
+	//	Non short-circuiting, so the compiler can evaluate every condition without branching
+	return (u >= 0.0f) & (v >= 0.0f) & (u + v <= 1.0f) & (t >= ray.min) & (t <= ray.max);
+}
+
+template<Triangle::CullMode CULL_MODE>
+inline bool HitTestTriangle(const PrecomputedTriangle& triangle, int triangleIndex, const Ray& ray, HitRecord& hitRecord)
+{
+	float t, u, v;
+	if (!GetTriangleHitDistance<CULL_MODE, false>(triangle, ray, t, u, v))
 		return false;
 
-	const Vector3
-		P{ rayOrigin + rayDirection * t },
-		* apVertices[]{ &v0, &v1, &v2 };
-	for (int index{}; index < 3; ++index)
+	if (t < hitRecord.t)
 	{
-		const Vector3
-			& startingVertex{ *apVertices[index] },
-			& endingVertex{ *apVertices[(index + 1) % 3] },
-			a{ endingVertex - startingVertex },
-			c{ P - startingVertex };
-
-		if (Vector3::Dot(Vector3::Cross(a, c), normal) < 0.0f)
-			return false;
+		SetHitRecord(triangleIndex, t, u, v, hitRecord);
+		return true;
 	}
 
-	if (ignoreHitRecord)
-		return true;
+	return false;
+}
 
-	if (t < hitRecord.t)
+//	Occlusion test for shadow rays
+template<Triangle::CullMode CULL_MODE>
+inline bool HitTestTriangle(const PrecomputedTriangle& triangle, const Ray& ray)
+{
+	float t, u, v;
+	return GetTriangleHitDistance<CULL_MODE, true>(triangle, ray, t, u, v);
+}
+
+inline bool HitTestTriangle(const Triangle& triangle, const Ray& ray, HitRecord& hitRecord, bool ignoreHitRecord = false)
+{
+	const PrecomputedTriangle precomputedTriangle(triangle.v0, triangle.v1, triangle.v2, triangle.normal);
+	return DispatchCullMode(triangle.cullMode,
+		[&precomputedTriangle, &ray, &hitRecord, ignoreHitRecord](auto cullMode)
+		{
+			if (ignoreHitRecord)
+				return HitTestTriangle<decltype(cullMode)::value>(precomputedTriangle, ray);
+
+			return HitTestTriangle<decltype(cullMode)::value>(precomputedTriangle, 0, ray, hitRecord);
+		});
+}
+
+//	Occlusion test for shadow rays
+inline bool HitTestTriangle(const Triangle& triangle, const Ray& ray)
+{
+	const PrecomputedTriangle precomputedTriangle(triangle.v0, triangle.v1, triangle.v2, triangle.normal);
+	return DispatchCullMode(triangle.cullMode,
+		[&precomputedTriangle, &ray](auto cullMode)
+		{
+			return HitTestTriangle<decltype(cullMode)::value>(precomputedTriangle, ray);
+		});
+}
+
+//	Expects the ray in the object space of the mesh and CULL_MODE to be the cull mode of the mesh
+template<Triangle::CullMode CULL_MODE>
+inline bool HitTestTriangleMeshTriangle(const TriangleMesh& triangleMesh, int triangleIndex, const Ray& ray, HitRecord& hitRecord)
+{
+	return HitTestTriangle<CULL_MODE>(triangleMesh.GetGeometry().vPrecomputedTriangles[triangleIndex], triangleIndex, ray, hitRecord);
+}
+
+//	Occlusion test for shadow rays, expects the ray in the object space of the mesh and CULL_MODE to be the cull mode of the mesh
+template<Triangle::CullMode CULL_MODE>
+inline bool HitTestTriangleMeshTriangle(const TriangleMesh& triangleMesh, int triangleIndex, const Ray& ray)
+{
+	return HitTestTriangle<CULL_MODE>(triangleMesh.GetGeometry().vPrecomputedTriangles[triangleIndex], ray);
+}
+
+//	GetTriangleHitDistance for the LANES::WIDTH triangles starting at index, laneMask selects the lanes to test. Returns the mask of the hit lanes
+template<typename LANES, Triangle::CullMode CULL_MODE, bool IS_SHADOW_RAY>
+inline int GetTriangleHitDistances(const WideTriangles& triangles, int index, int laneMask, const Ray& ray, typename LANES::Type& t, typename LANES::Type& u, typename LANES::Type& v)
+{
+	using Type = typename LANES::Type;
+
+	const auto load
 	{
-		hitRecord.t = t;
+		[&triangles, index](WideTriangles::Component component)
+		{
+			return LANES::Load(triangles.GetComponent(component, index));
+		}
+	};
 
-		hitRecord.origin = P;
-		hitRecord.normal = signbit(dotRayDirectionNormal) ? normal : -normal;
+	const auto dot
+	{
+		[](Type x1, Type y1, Type z1, Type x2, Type y2, Type z2)
+		{
+			return LANES::Add(LANES::Add(LANES::Multiply(x1, x2), LANES::Multiply(y1, y2)), LANES::Multiply(z1, z2));
+		}
+	};
 
-		hitRecord.didHit = true;
-		hitRecord.materialIndex = triangle.materialIndex;
-		return true;
+	//	One component of a cross product, a1 * b2 - b1 * a2
+	const auto cross
+	{
+		[](Type a1, Type b2, Type b1, Type a2)
+		{
+			return LANES::Subtract(LANES::Multiply(a1, b2), LANES::Multiply(b1, a2));
+		}
+	};
+
+	const Type
+		directionX{ LANES::Set(ray.direction.x) },
+		directionY{ LANES::Set(ray.direction.y) },
+		directionZ{ LANES::Set(ray.direction.z) },
+		edge1X{ load(WideTriangles::edge1X) },
+		edge1Y{ load(WideTriangles::edge1Y) },
+		edge1Z{ load(WideTriangles::edge1Z) },
+		edge2X{ load(WideTriangles::edge2X) },
+		edge2Y{ load(WideTriangles::edge2Y) },
+		edge2Z{ load(WideTriangles::edge2Z) },
+		zero{ LANES::Set(0.0f) };
+
+	Type dotNormalRayDirection{ dot(load(WideTriangles::normalX), load(WideTriangles::normalY), load(WideTriangles::normalZ), directionX, directionY, directionZ) };
+	if constexpr (IS_SHADOW_RAY)
+		dotNormalRayDirection = LANES::Subtract(zero, dotNormalRayDirection);
+
+	int mask{ laneMask };
+	if constexpr (CULL_MODE == Triangle::CullMode::frontFace)
+		mask &= LANES::GetGreaterMask(dotNormalRayDirection, zero);
+	else if constexpr (CULL_MODE == Triangle::CullMode::backFace)
+		mask &= LANES::GetLessMask(dotNormalRayDirection, zero);
+	else
+		mask &= LANES::GetGreaterEqualMask(LANES::GetAbsolute(dotNormalRayDirection), LANES::Set(FLT_EPSILON));
+
+	if (!mask)
+		return 0;
+
+	const Type
+		pX{ cross(directionY, edge2Z, directionZ, edge2Y) },
+		pY{ cross(directionZ, edge2X, directionX, edge2Z) },
+		pZ{ cross(directionX, edge2Y, directionY, edge2X) },
+		sX{ LANES::Subtract(LANES::Set(ray.origin.x), load(WideTriangles::v0X)) },
+		sY{ LANES::Subtract(LANES::Set(ray.origin.y), load(WideTriangles::v0Y)) },
+		sZ{ LANES::Subtract(LANES::Set(ray.origin.z), load(WideTriangles::v0Z)) },
+		qX{ cross(sY, edge1Z, sZ, edge1Y) },
+		qY{ cross(sZ, edge1X, sX, edge1Z) },
+		qZ{ cross(sX, edge1Y, sY, edge1X) },
+		inverseDeterminant{ LANES::Divide(LANES::Set(1.0f), dot(edge1X, edge1Y, edge1Z, pX, pY, pZ)) };
+
+	u = LANES::Multiply(dot(sX, sY, sZ, pX, pY, pZ), inverseDeterminant);
+	v = LANES::Multiply(dot(directionX, directionY, directionZ, qX, qY, qZ), inverseDeterminant);
+	t = LANES::Multiply(dot(edge2X, edge2Y, edge2Z, qX, qY, qZ), inverseDeterminant);
+
+	return mask
+		& LANES::GetGreaterEqualMask(u, zero)
+		& LANES::GetGreaterEqualMask(v, zero)
+		& LANES::GetLessEqualMask(LANES::Add(u, v), LANES::Set(1.0f))
+		& LANES::GetGreaterEqualMask(t, LANES::Set(ray.min))
+		& LANES::GetLessEqualMask(t, LANES::Set(ray.max));
+}
+
+//	Tests the triangles of a leaf a register width at a time, firstIndex and primitiveAmount describe the leaf range in BVH primitive order.
+//	Expects the ray in the object space of the mesh and CULL_MODE to be the cull mode of the mesh
+template<InstructionSet INSTRUCTION_SET, Triangle::CullMode CULL_MODE>
+inline bool HitTestTriangleMeshLeaf(const TriangleMesh& triangleMesh, int firstIndex, int primitiveAmount, const Ray& ray, HitRecord& hitRecord)
+{
+	using Lanes = FloatLanes<INSTRUCTION_SET>;
+
+	const TriangleMeshGeometry& geometry{ triangleMesh.GetGeometry() };
+	const WideTriangles& triangles{ geometry.wideTriangles };
+	const int endIndex{ firstIndex + primitiveAmount };
+
+	bool didHit{};
+	for (int index{ firstIndex }; index < endIndex; index += Lanes::WIDTH)
+	{
+		typename Lanes::Type t, u, v;
+		int hitMask{ GetTriangleHitDistances<Lanes, CULL_MODE, false>(triangles, index, (1 << std::min(endIndex - index, Lanes::WIDTH)) - 1, ray, t, u, v) };
+		hitMask &= Lanes::GetLessMask(t, Lanes::Set(hitRecord.t));
+		if (!hitMask)
+			continue;
+
+		const int nearestLane{ GetNearestLane<Lanes>(hitMask, t) };
+		SetHitRecord(geometry.bvh.GetPrimitiveIndices()[index + nearestLane], GetLane<Lanes>(t, nearestLane), GetLane<Lanes>(u, nearestLane), GetLane<Lanes>(v, nearestLane), hitRecord);
+		didHit = true;
+	}
+
+	return didHit;
+}
+
+//	Occlusion test for shadow rays, expects the ray in the object space of the mesh and CULL_MODE to be the cull mode of the mesh
+template<InstructionSet INSTRUCTION_SET, Triangle::CullMode CULL_MODE>
+inline bool HitTestTriangleMeshLeaf(const TriangleMesh& triangleMesh, int firstIndex, int primitiveAmount, const Ray& ray)
+{
+	using Lanes = FloatLanes<INSTRUCTION_SET>;
+
+	const WideTriangles& triangles{ triangleMesh.GetGeometry().wideTriangles };
+	const int endIndex{ firstIndex + primitiveAmount };
+
+	for (int index{ firstIndex }; index < endIndex; index += Lanes::WIDTH)
+	{
+		typename Lanes::Type t, u, v;
+		if (GetTriangleHitDistances<Lanes, CULL_MODE, true>(triangles, index, (1 << std::min(endIndex - index, Lanes::WIDTH)) - 1, ray, t, u, v))
+			return true;
 	}
 
 	return false;
 }
 
-inline bool HitTestTriangle(const Triangle& triangle, const Ray& ray)
+//	Calls function with the instruction set picked at startup and the cull mode of a mesh, as std::integral_constants
+template<typename Function>
+inline auto DispatchTriangleLeafKernel(Triangle::CullMode cullMode, Function function)
 {
-	HitRecord temporary;
-	return HitTestTriangle(triangle, ray, temporary, true);
+	return DispatchInstructionSet(GetInstructionSet(),
+		[cullMode, &function](auto instructionSet)
+		{
+			return DispatchCullMode(cullMode,
+				[instructionSet, &function](auto cullMode)
+				{
+					return function(instructionSet, cullMode);
+				});
+		});
 }
 
-inline bool HitTestTriangleMesh(const TriangleMesh& triangleMesh, const Ray& ray, HitRecord& hitRecord, bool ignoreHitRecord = false)
+//	The direction does not get normalized, so t stays the same in object and world space
+inline Ray GetObjectSpaceRay(const TriangleMesh& triangleMesh, const Ray& ray)
 {
-	if (!SlabTestTriangleMesh(triangleMesh, ray))
+	const Matrix& inverseTransform{ triangleMesh.GetInverseTransform() };
+	return Ray(inverseTransform.TransformPoint(ray.origin), inverseTransform.TransformVector(ray.direction), ray.min, ray.max);
+}
+
+//	World space normal of a hit triangle, facing against the world space ray it got hit by
+inline Vector3 GetTriangleMeshNormal(const TriangleMesh& triangleMesh, int triangleIndex, const Ray& ray)
+{
+	const Matrix& inverseTransform{ triangleMesh.GetInverseTransform() };
+	const Vector3& normal{ triangleMesh.GetGeometry().vPrecomputedTriangles[triangleIndex].normal };
+
+	const Vector3 facingNormal{ signbit(Vector3::Dot(inverseTransform.TransformVector(ray.direction), normal)) ? normal : -normal };
+	return inverseTransform.TransformVectorTransposed(facingNormal).GetNormalized();
+}
+
+//	Visits the nearest child first and shrinks the ray to the closest hit found so far, so farther subtrees get culled by the slab test
+//	hitTestLeaf(firstIndex, primitiveAmount, ray, hitRecord) tests a range of the BVH primitive order and has to behave like the other hit test functions
+template<typename HitTestLeafFunction>
+inline bool HitTestBVHLeaves(const BVH& bvh, const Ray& ray, HitRecord& hitRecord, HitTestLeafFunction hitTestLeaf)
+{
+	const std::vector<BVHNode>& vNodes{ bvh.GetNodes() };
+	const Vector3 inverseRayDirection{ GetInverseDirection(ray.direction) };
+
+	Ray shrinkingRay{ ray };
+	shrinkingRay.max = std::min(ray.max, hitRecord.t);
+
+	float tEntry;
+	if (vNodes.empty() || !SlabTest(vNodes[0].bounds, shrinkingRay, inverseRayDirection, tEntry))
 		return false;
 
+	struct StackEntry
+	{
+		int nodeIndex;
+		float tEntry;
+	};
+
+	StackEntry aStack[BVH::MAX_DEPTH];
+	int stackSize{};
+
 	bool didHit{};
-	for (size_t index{}; index < triangleMesh.vIndices.size(); index += 3)
+	int nodeIndex{};
+	while (true)
 	{
-		if (HitTestTriangle(
-			Triangle(
-				triangleMesh.vPositionsTransformed[triangleMesh.vIndices[index]],
-				triangleMesh.vPositionsTransformed[triangleMesh.vIndices[index + 1]],
-				triangleMesh.vPositionsTransformed[triangleMesh.vIndices[index + 2]],
-				triangleMesh.vNormalsTransformed[index / 3],
-				triangleMesh.materialIndex,
-				triangleMesh.cullMode), ray, hitRecord, ignoreHitRecord))
+		const BVHNode& node{ vNodes[nodeIndex] };
+		if (node.IsLeaf())
 		{
-			if (ignoreHitRecord)
+			if (hitTestLeaf(node.leftFirst, node.primitiveAmount, shrinkingRay, hitRecord))
+			{
+				didHit = true;
+				shrinkingRay.max = hitRecord.t;
+			}
+
+			do
+			{
+				if (!stackSize)
+					return didHit;
+
+				nodeIndex = aStack[--stackSize].nodeIndex;
+			} while (aStack[stackSize].tEntry > shrinkingRay.max);
+
+			continue;
+		}
+
+		int
+			nearChildIndex{ node.leftFirst },
+			farChildIndex{ node.leftFirst + 1 };
+
+		float
+			tNearEntry,
+			tFarEntry;
+
+		bool
+			didHitNearChild{ SlabTest(vNodes[nearChildIndex].bounds, shrinkingRay, inverseRayDirection, tNearEntry) },
+			didHitFarChild{ SlabTest(vNodes[farChildIndex].bounds, shrinkingRay, inverseRayDirection, tFarEntry) };
+
+		if (tFarEntry < tNearEntry)
+		{
+			std::swap(nearChildIndex, farChildIndex);
+			std::swap(tNearEntry, tFarEntry);
+			std::swap(didHitNearChild, didHitFarChild);
+		}
+
+		if (didHitNearChild)
+		{
+			if (didHitFarChild)
+				aStack[stackSize++] = StackEntry(farChildIndex, tFarEntry);
+
+			nodeIndex = nearChildIndex;
+		}
+		else if (didHitFarChild)
+			nodeIndex = farChildIndex;
+		else
+		{
+			do
+			{
+				if (!stackSize)
+					return didHit;
+
+				nodeIndex = aStack[--stackSize].nodeIndex;
+			} while (aStack[stackSize].tEntry > shrinkingRay.max);
+		}
+	}
+}
+
+//	Any hit traversal for occlusion: returns at the first leaf hit by hitTestLeaf(firstIndex, primitiveAmount, ray) and never computes attributes.
+//	Any hit ends the traversal no matter how far it is, so instead of the nearest child the one the ray travels the longest distance through
+//	gets visited first, it is the most likely to contain an occluder
+template<typename HitTestLeafFunction>
+inline bool HitTestBVHLeaves(const BVH& bvh, const Ray& ray, HitTestLeafFunction hitTestLeaf)
+{
+	const std::vector<BVHNode>& vNodes{ bvh.GetNodes() };
+	const Vector3 inverseRayDirection{ GetInverseDirection(ray.direction) };
+
+	float tEntry;
+	if (vNodes.empty() || !SlabTest(vNodes[0].bounds, ray, inverseRayDirection, tEntry))
+		return false;
+
+	int
+		aStack[BVH::MAX_DEPTH],
+		stackSize{},
+		nodeIndex{};
+
+	while (true)
+	{
+		const BVHNode& node{ vNodes[nodeIndex] };
+		if (node.IsLeaf())
+		{
+			if (hitTestLeaf(node.leftFirst, node.primitiveAmount, ray))
 				return true;
-			
-			didHit = true;
+
+			if (!stackSize)
+				return false;
+
+			nodeIndex = aStack[--stackSize];
+			continue;
+		}
+
+		int
+			longChildIndex{ node.leftFirst },
+			shortChildIndex{ node.leftFirst + 1 };
+
+		float
+			tLongEntry,
+			tLongExit,
+			tShortEntry,
+			tShortExit;
+
+		bool
+			didHitLongChild{ SlabTest(vNodes[longChildIndex].bounds, ray, inverseRayDirection, tLongEntry, tLongExit) },
+			didHitShortChild{ SlabTest(vNodes[shortChildIndex].bounds, ray, inverseRayDirection, tShortEntry, tShortExit) };
+
+		if (tShortExit - tShortEntry > tLongExit - tLongEntry)
+		{
+			std::swap(longChildIndex, shortChildIndex);
+			std::swap(didHitLongChild, didHitShortChild);
+		}
+
+		if (didHitLongChild)
+		{
+			if (didHitShortChild)
+				aStack[stackSize++] = shortChildIndex;
+
+			nodeIndex = longChildIndex;
+		}
+		else if (didHitShortChild)
+			nodeIndex = shortChildIndex;
+		else
+		{
+			if (!stackSize)
+				return false;
+
+			nodeIndex = aStack[--stackSize];
+		}
+	}
+}
+
+//	HitTestBVHLeaves testing the primitives of a leaf one at a time with hitTestPrimitive(primitiveIndex, ray, hitRecord)
+template<typename HitTestPrimitiveFunction>
+inline bool HitTestBVH(const BVH& bvh, const Ray& ray, HitRecord& hitRecord, HitTestPrimitiveFunction hitTestPrimitive)
+{
+	const std::vector<int>& vPrimitiveIndices{ bvh.GetPrimitiveIndices() };
+	return HitTestBVHLeaves(bvh, ray, hitRecord,
+		[&vPrimitiveIndices, &hitTestPrimitive](int firstIndex, int primitiveAmount, const Ray& ray, HitRecord& hitRecord)
+		{
+			Ray shrinkingRay{ ray };
+
+			bool didHit{};
+			for (int index{ firstIndex }; index < firstIndex + primitiveAmount; ++index)
+				if (hitTestPrimitive(vPrimitiveIndices[index], shrinkingRay, hitRecord))
+				{
+					didHit = true;
+					shrinkingRay.max = hitRecord.t;
+				}
+
+			return didHit;
+		});
+}
+
+//	Any hit HitTestBVHLeaves testing the primitives of a leaf one at a time with hitTestPrimitive(primitiveIndex, ray)
+template<typename HitTestPrimitiveFunction>
+inline bool HitTestBVH(const BVH& bvh, const Ray& ray, HitTestPrimitiveFunction hitTestPrimitive)
+{
+	const std::vector<int>& vPrimitiveIndices{ bvh.GetPrimitiveIndices() };
+	return HitTestBVHLeaves(bvh, ray,
+		[&vPrimitiveIndices, &hitTestPrimitive](int firstIndex, int primitiveAmount, const Ray& ray)
+		{
+			for (int index{ firstIndex }; index < firstIndex + primitiveAmount; ++index)
+				if (hitTestPrimitive(vPrimitiveIndices[index], ray))
+					return true;
+
+			return false;
+		});
+}
+
+//	Bounds on the origins and inverse directions of the active rays of a packet, x y z in the first three lanes. As long as the rays agree
+//	on the direction signs, interval arithmetic on these bounds rejects a box missed by every ray of the packet with a single test
+struct RayPacketInterval
+{
+public:
+	__m128
+		smallestOrigin,
+		largestOrigin,
+		smallestInverseDirection,
+		largestInverseDirection,
+		isPositive;
+
+	float
+		min,
+		max;
+
+	bool isValid;
+};
+
+inline RayPacketInterval GetRayPacketInterval(const RayPacket& packet)
+{
+	Vector3
+		smallestOrigin{ FLT_MAX, FLT_MAX, FLT_MAX },
+		largestOrigin{ -FLT_MAX, -FLT_MAX, -FLT_MAX },
+		smallestInverseDirection{ FLT_MAX, FLT_MAX, FLT_MAX },
+		largestInverseDirection{ -FLT_MAX, -FLT_MAX, -FLT_MAX };
+
+	float
+		min{ FLT_MAX },
+		max{ -FLT_MAX };
+
+	for (int mask{ packet.activeMask }; mask; mask &= mask - 1)
+	{
+		const int lane{ std::countr_zero(static_cast<unsigned int>(mask)) };
+		const Vector3
+			origin{ packet.aOriginX[lane], packet.aOriginY[lane], packet.aOriginZ[lane] },
+			inverseDirection{ packet.aInverseDirectionX[lane], packet.aInverseDirectionY[lane], packet.aInverseDirectionZ[lane] };
+
+		smallestOrigin = Vector3::GetSmallestComponents(smallestOrigin, origin);
+		largestOrigin = Vector3::GetLargestComponents(largestOrigin, origin);
+		smallestInverseDirection = Vector3::GetSmallestComponents(smallestInverseDirection, inverseDirection);
+		largestInverseDirection = Vector3::GetLargestComponents(largestInverseDirection, inverseDirection);
+		min = std::min(min, packet.aMin[lane]);
+		max = std::max(max, packet.aMax[lane]);
+	}
+
+	//	Mixed signs or axis aligned rays would need the near and far planes swapped per ray
+	bool isValid{ packet.activeMask != 0 };
+	for (int axis{}; axis < 3; ++axis)
+		isValid = isValid
+			&& std::signbit(smallestInverseDirection[axis]) == std::signbit(largestInverseDirection[axis])
+			&& std::isfinite(smallestInverseDirection[axis]) && std::isfinite(largestInverseDirection[axis]);
+
+	const auto load{ [](const Vector3& vector) { return _mm_setr_ps(vector.x, vector.y, vector.z, 0.0f); } };
+	return RayPacketInterval(
+		load(smallestOrigin),
+		load(largestOrigin),
+		load(smallestInverseDirection),
+		load(largestInverseDirection),
+		_mm_cmpgt_ps(load(smallestInverseDirection), _mm_setzero_ps()),
+		min,
+		max,
+		isValid);
+}
+
+//	False only if every ray of the interval misses the box. Rounding is monotonic, so the bounds stay conservative in floating point too
+inline bool SlabTest(const AABB& aabb, const RayPacketInterval& interval)
+{
+	const __m128
+		smallest{ _mm_setr_ps(aabb.smallest.x, aabb.smallest.y, aabb.smallest.z, 0.0f) },
+		largest{ _mm_setr_ps(aabb.largest.x, aabb.largest.y, aabb.largest.z, 0.0f) },
+		nearPlane{ _mm_or_ps(_mm_and_ps(interval.isPositive, smallest), _mm_andnot_ps(interval.isPositive, largest)) },
+		farPlane{ _mm_or_ps(_mm_and_ps(interval.isPositive, largest), _mm_andnot_ps(interval.isPositive, smallest)) },
+		smallestNearDistance{ _mm_sub_ps(nearPlane, interval.largestOrigin) },
+		largestNearDistance{ _mm_sub_ps(nearPlane, interval.smallestOrigin) },
+		smallestFarDistance{ _mm_sub_ps(farPlane, interval.largestOrigin) },
+		largestFarDistance{ _mm_sub_ps(farPlane, interval.smallestOrigin) },
+		tEntries{ _mm_min_ps(
+			_mm_min_ps(_mm_mul_ps(smallestNearDistance, interval.smallestInverseDirection), _mm_mul_ps(smallestNearDistance, interval.largestInverseDirection)),
+			_mm_min_ps(_mm_mul_ps(largestNearDistance, interval.smallestInverseDirection), _mm_mul_ps(largestNearDistance, interval.largestInverseDirection))) },
+		tExits{ _mm_max_ps(
+			_mm_max_ps(_mm_mul_ps(smallestFarDistance, interval.smallestInverseDirection), _mm_mul_ps(smallestFarDistance, interval.largestInverseDirection)),
+			_mm_max_ps(_mm_mul_ps(largestFarDistance, interval.smallestInverseDirection), _mm_mul_ps(largestFarDistance, interval.largestInverseDirection))) },
+		tEntry{ _mm_max_ps(tEntries, _mm_max_ps(_mm_shuffle_ps(tEntries, tEntries, _MM_SHUFFLE(3, 0, 2, 1)), _mm_shuffle_ps(tEntries, tEntries, _MM_SHUFFLE(3, 1, 0, 2)))) },
+		tExit{ _mm_min_ps(tExits, _mm_min_ps(_mm_shuffle_ps(tExits, tExits, _MM_SHUFFLE(3, 0, 2, 1)), _mm_shuffle_ps(tExits, tExits, _MM_SHUFFLE(3, 1, 0, 2)))) };
+
+	return std::max(_mm_cvtss_f32(tEntry), interval.min) <= std::min(_mm_cvtss_f32(tExit), interval.max);
+}
+
+//	Slab tests the lanes of laneMask four at a time, returns the mask of the lanes that hit the box and their entry and exit distances
+inline int SlabTest(const AABB& aabb, const RayPacket& packet, const RayPacketInterval& interval, int laneMask, float aTEntries[RayPacket::SIZE], float aTExits[RayPacket::SIZE])
+{
+	if (!laneMask || (interval.isValid && !SlabTest(aabb, interval)))
+		return 0;
+
+	const __m128
+		smallestX{ _mm_set1_ps(aabb.smallest.x) },
+		smallestY{ _mm_set1_ps(aabb.smallest.y) },
+		smallestZ{ _mm_set1_ps(aabb.smallest.z) },
+		largestX{ _mm_set1_ps(aabb.largest.x) },
+		largestY{ _mm_set1_ps(aabb.largest.y) },
+		largestZ{ _mm_set1_ps(aabb.largest.z) };
+
+	int hitMask{};
+	for (int lane{}; lane < RayPacket::SIZE; lane += 4)
+	{
+		if (!((laneMask >> lane) & 0b1111))
+			continue;
+
+		const __m128
+			originX{ _mm_load_ps(packet.aOriginX + lane) },
+			originY{ _mm_load_ps(packet.aOriginY + lane) },
+			originZ{ _mm_load_ps(packet.aOriginZ + lane) },
+			inverseDirectionX{ _mm_load_ps(packet.aInverseDirectionX + lane) },
+			inverseDirectionY{ _mm_load_ps(packet.aInverseDirectionY + lane) },
+			inverseDirectionZ{ _mm_load_ps(packet.aInverseDirectionZ + lane) },
+			tx1{ _mm_mul_ps(_mm_sub_ps(smallestX, originX), inverseDirectionX) },
+			tx2{ _mm_mul_ps(_mm_sub_ps(largestX, originX), inverseDirectionX) },
+			ty1{ _mm_mul_ps(_mm_sub_ps(smallestY, originY), inverseDirectionY) },
+			ty2{ _mm_mul_ps(_mm_sub_ps(largestY, originY), inverseDirectionY) },
+			tz1{ _mm_mul_ps(_mm_sub_ps(smallestZ, originZ), inverseDirectionZ) },
+			tz2{ _mm_mul_ps(_mm_sub_ps(largestZ, originZ), inverseDirectionZ) },
+			tMin{ _mm_max_ps(_mm_max_ps(_mm_min_ps(tx1, tx2), _mm_min_ps(ty1, ty2)), _mm_min_ps(tz1, tz2)) },
+			tMax{ _mm_min_ps(_mm_min_ps(_mm_max_ps(tx1, tx2), _mm_max_ps(ty1, ty2)), _mm_max_ps(tz1, tz2)) },
+			didHit{ _mm_and_ps(_mm_cmpge_ps(tMax, tMin), _mm_and_ps(_mm_cmpge_ps(tMax, _mm_load_ps(packet.aMin + lane)), _mm_cmple_ps(tMin, _mm_load_ps(packet.aMax + lane)))) };
+
+		_mm_store_ps(aTEntries + lane, tMin);
+		_mm_store_ps(aTExits + lane, tMax);
+		hitMask |= _mm_movemask_ps(didHit) << lane;
+	}
+
+	return hitMask & laneMask;
+}
+
+//	Packet traversal: both children get tested against the lanes that hit their parent and the first of those lanes decides the order,
+//	the nearest child first or for occlusion the one it travels the longest distance through.
+//	hitTestLeaf(firstIndex, primitiveAmount, laneMask) tests the given lanes and has to keep the packet up to date: closest hit traversals
+//	shrink aMax to the hits, occlusion traversals clear the activeMask bits of occluded lanes
+template<bool IS_OCCLUSION, typename HitTestLeafFunction>
+inline void HitTestBVHLeaves(const BVH& bvh, RayPacket& packet, HitTestLeafFunction hitTestLeaf)
+{
+	const std::vector<BVHNode>& vNodes{ bvh.GetNodes() };
+	const RayPacketInterval interval{ GetRayPacketInterval(packet) };
+
+	alignas(16) float
+		aTLeftEntries[RayPacket::SIZE],
+		aTLeftExits[RayPacket::SIZE],
+		aTRightEntries[RayPacket::SIZE],
+		aTRightExits[RayPacket::SIZE];
+
+	if (vNodes.empty() || !SlabTest(vNodes[0].bounds, packet, interval, packet.activeMask, aTLeftEntries, aTLeftExits))
+		return;
+
+	struct StackEntry
+	{
+		int
+			nodeIndex,
+			laneMask;
+	};
+
+	StackEntry aStack[BVH::MAX_DEPTH];
+	int stackSize{};
+
+	StackEntry entry{ 0, packet.activeMask };
+	while (true)
+	{
+		const BVHNode& node{ vNodes[entry.nodeIndex] };
+		if (node.IsLeaf())
+		{
+			hitTestLeaf(node.leftFirst, node.primitiveAmount, entry.laneMask & packet.activeMask);
+			if (!packet.activeMask)
+				return;
+		}
+		else
+		{
+			const int
+				laneMask{ entry.laneMask & packet.activeMask },
+				leftMask{ SlabTest(vNodes[node.leftFirst].bounds, packet, interval, laneMask, aTLeftEntries, aTLeftExits) },
+				rightMask{ SlabTest(vNodes[node.leftFirst + 1].bounds, packet, interval, laneMask, aTRightEntries, aTRightExits) };
+
+			if (leftMask && rightMask)
+			{
+				const int lane{ std::countr_zero(static_cast<unsigned int>(leftMask | rightMask)) };
+
+				bool isLeftChildFirst;
+				if (!((leftMask >> lane) & 1) || !((rightMask >> lane) & 1))
+					isLeftChildFirst = (leftMask >> lane) & 1;
+				else if constexpr (IS_OCCLUSION)
+					isLeftChildFirst = aTLeftExits[lane] - aTLeftEntries[lane] >= aTRightExits[lane] - aTRightEntries[lane];
+				else
+					isLeftChildFirst = aTLeftEntries[lane] <= aTRightEntries[lane];
+
+				aStack[stackSize++] = isLeftChildFirst ? StackEntry(node.leftFirst + 1, rightMask) : StackEntry(node.leftFirst, leftMask);
+				entry = isLeftChildFirst ? StackEntry(node.leftFirst, leftMask) : StackEntry(node.leftFirst + 1, rightMask);
+				continue;
+			}
+
+			if (leftMask || rightMask)
+			{
+				entry = leftMask ? StackEntry(node.leftFirst, leftMask) : StackEntry(node.leftFirst + 1, rightMask);
+				continue;
+			}
+		}
+
+		//	Lanes that got occluded or found a closer hit since the push get dropped by the mask and the slab tests
+		do
+		{
+			if (!stackSize)
+				return;
+
+			entry = aStack[--stackSize];
+		} while (!(entry.laneMask & packet.activeMask));
+	}
+}
+
+//	The ray broadcast into SSE registers, to slab test the four children of a wide node at once
+struct WideRay
+{
+public:
+	__m128
+		originX,
+		originY,
+		originZ,
+		inverseDirectionX,
+		inverseDirectionY,
+		inverseDirectionZ,
+		min;
+};
+
+inline WideRay GetWideRay(const Ray& ray)
+{
+	const Vector3 inverseRayDirection{ GetInverseDirection(ray.direction) };
+	return WideRay(
+		_mm_set1_ps(ray.origin.x),
+		_mm_set1_ps(ray.origin.y),
+		_mm_set1_ps(ray.origin.z),
+		_mm_set1_ps(inverseRayDirection.x),
+		_mm_set1_ps(inverseRayDirection.y),
+		_mm_set1_ps(inverseRayDirection.z),
+		_mm_set1_ps(ray.min));
+}
+
+//	Returns the mask of the children entered before rayMax, along with their entry and exit distances
+inline int SlabTest(const WideRay& wideRay, float rayMax, __m128 smallestX, __m128 smallestY, __m128 smallestZ, __m128 largestX, __m128 largestY, __m128 largestZ, __m128& tEntries, __m128& tExits)
+{
+	const __m128
+		tx1{ _mm_mul_ps(_mm_sub_ps(smallestX, wideRay.originX), wideRay.inverseDirectionX) },
+		tx2{ _mm_mul_ps(_mm_sub_ps(largestX, wideRay.originX), wideRay.inverseDirectionX) },
+		ty1{ _mm_mul_ps(_mm_sub_ps(smallestY, wideRay.originY), wideRay.inverseDirectionY) },
+		ty2{ _mm_mul_ps(_mm_sub_ps(largestY, wideRay.originY), wideRay.inverseDirectionY) },
+		tz1{ _mm_mul_ps(_mm_sub_ps(smallestZ, wideRay.originZ), wideRay.inverseDirectionZ) },
+		tz2{ _mm_mul_ps(_mm_sub_ps(largestZ, wideRay.originZ), wideRay.inverseDirectionZ) };
+
+	tEntries = _mm_max_ps(_mm_max_ps(_mm_min_ps(tx1, tx2), _mm_min_ps(ty1, ty2)), _mm_max_ps(_mm_min_ps(tz1, tz2), wideRay.min));
+	tExits = _mm_min_ps(_mm_min_ps(_mm_max_ps(tx1, tx2), _mm_max_ps(ty1, ty2)), _mm_min_ps(_mm_max_ps(tz1, tz2), _mm_set1_ps(rayMax)));
+	return _mm_movemask_ps(_mm_cmple_ps(tEntries, tExits));
+}
+
+inline int SlabTest(const WideBVHNode& node, const WideRay& wideRay, float rayMax, __m128& tEntries, __m128& tExits)
+{
+	const int hitMask
+	{
+		SlabTest(wideRay, rayMax,
+			_mm_load_ps(node.aSmallestX), _mm_load_ps(node.aSmallestY), _mm_load_ps(node.aSmallestZ),
+			_mm_load_ps(node.aLargestX), _mm_load_ps(node.aLargestY), _mm_load_ps(node.aLargestZ),
+			tEntries, tExits)
+	};
+
+	const __m128i primitiveAmounts{ _mm_load_si128(reinterpret_cast<const __m128i*>(node.aPrimitiveAmounts)) };
+	return hitMask & _mm_movemask_ps(_mm_castsi128_ps(_mm_cmpgt_epi32(primitiveAmounts, _mm_set1_epi32(-1))));
+}
+
+//	The child boxes get dequantized first; they can only be larger than the full precision ones, so more boxes may be entered but no hit is missed
+inline int SlabTest(const QuantizedWideBVHNode& node, const WideRay& wideRay, float rayMax, __m128& tEntries, __m128& tExits)
+{
+	const __m128i zero{ _mm_setzero_si128() };
+
+	//	The smallest X, Y, Z and largest X steps fill one register, the largest Y and Z steps half of another
+	const __m128i
+		aSteps0{ _mm_load_si128(reinterpret_cast<const __m128i*>(node.aSmallestX)) },
+		aSteps1{ _mm_loadl_epi64(reinterpret_cast<const __m128i*>(node.aLargestY)) },
+		aWideSteps0{ _mm_unpacklo_epi8(aSteps0, zero) },
+		aWideSteps1{ _mm_unpackhi_epi8(aSteps0, zero) },
+		aWideSteps2{ _mm_unpacklo_epi8(aSteps1, zero) };
+
+	const __m128
+		originX{ _mm_set1_ps(node.aOrigin[0]) },
+		originY{ _mm_set1_ps(node.aOrigin[1]) },
+		originZ{ _mm_set1_ps(node.aOrigin[2]) },
+		scaleX{ _mm_set1_ps(QuantizedWideBVHNode::GetScale(node.aScaleExponents[0])) },
+		scaleY{ _mm_set1_ps(QuantizedWideBVHNode::GetScale(node.aScaleExponents[1])) },
+		scaleZ{ _mm_set1_ps(QuantizedWideBVHNode::GetScale(node.aScaleExponents[2])) };
+
+	return node.usedChildMask & SlabTest(wideRay, rayMax,
+		_mm_add_ps(originX, _mm_mul_ps(_mm_cvtepi32_ps(_mm_unpacklo_epi16(aWideSteps0, zero)), scaleX)),
+		_mm_add_ps(originY, _mm_mul_ps(_mm_cvtepi32_ps(_mm_unpackhi_epi16(aWideSteps0, zero)), scaleY)),
+		_mm_add_ps(originZ, _mm_mul_ps(_mm_cvtepi32_ps(_mm_unpacklo_epi16(aWideSteps1, zero)), scaleZ)),
+		_mm_add_ps(originX, _mm_mul_ps(_mm_cvtepi32_ps(_mm_unpackhi_epi16(aWideSteps1, zero)), scaleX)),
+		_mm_add_ps(originY, _mm_mul_ps(_mm_cvtepi32_ps(_mm_unpacklo_epi16(aWideSteps2, zero)), scaleY)),
+		_mm_add_ps(originZ, _mm_mul_ps(_mm_cvtepi32_ps(_mm_unpackhi_epi16(aWideSteps2, zero)), scaleZ)),
+		tEntries, tExits);
+}
+
+//	Index of the child node for internal children (primitive amount 0), index of the first primitive index for leaves
+inline void GetChild(const WideBVHNode& node, int child, int& index, int& primitiveAmount)
+{
+	index = node.aChildIndices[child];
+	primitiveAmount = node.aPrimitiveAmounts[child];
+}
+
+inline void GetChild(const QuantizedWideBVHNode& node, int child, int& index, int& primitiveAmount)
+{
+	const unsigned int packedChild{ node.aChildren[child] };
+	const bool isLeaf{ QuantizedWideBVHNode::IsLeaf(packedChild) };
+	index = isLeaf ? QuantizedWideBVHNode::GetFirstPrimitive(packedChild) : static_cast<int>(packedChild);
+	primitiveAmount = isLeaf ? QuantizedWideBVHNode::GetPrimitiveAmount(packedChild) : 0;
+}
+
+//	Same contract as HitTestBVHLeaves for both wide node layouts, every node tests its four child boxes with one SSE slab test
+template<typename WideNode, typename HitTestLeafFunction>
+inline bool HitTestWideNodes(const std::vector<WideNode>& vNodes, const Ray& ray, HitRecord& hitRecord, HitTestLeafFunction hitTestLeaf)
+{
+	if (vNodes.empty())
+		return false;
+
+	Ray shrinkingRay{ ray };
+	shrinkingRay.max = std::min(ray.max, hitRecord.t);
+
+	const WideRay wideRay{ GetWideRay(ray) };
+
+	struct StackEntry
+	{
+		int
+			index,
+			primitiveAmount;
+
+		float tEntry;
+	};
+
+	StackEntry aStack[(BVH::WIDTH - 1) * BVH::MAX_DEPTH + 1];
+	aStack[0] = StackEntry(0, 0, ray.min);
+	int stackSize{ 1 };
+
+	bool didHit{};
+	while (stackSize)
+	{
+		const StackEntry entry{ aStack[--stackSize] };
+		if (entry.tEntry > shrinkingRay.max)
+			continue;
+
+		if (entry.primitiveAmount)
+		{
+			if (hitTestLeaf(entry.index, entry.primitiveAmount, shrinkingRay, hitRecord))
+			{
+				didHit = true;
+				shrinkingRay.max = hitRecord.t;
+			}
+
+			continue;
+		}
+
+		__m128
+			tEntries,
+			tExits;
+
+		int hitMask{ SlabTest(vNodes[entry.index], wideRay, shrinkingRay.max, tEntries, tExits) };
+		if (!hitMask)
+			continue;
+
+		alignas(16) float aTEntries[BVH::WIDTH];
+		_mm_store_ps(aTEntries, tEntries);
+
+		//	Insert the hit children sorted from far to near, so the nearest one gets popped first
+		const int firstStackIndex{ stackSize };
+		while (hitMask)
+		{
+			const int child{ std::countr_zero(static_cast<unsigned int>(hitMask)) };
+			hitMask &= hitMask - 1;
+
+			StackEntry childEntry{ 0, 0, aTEntries[child] };
+			GetChild(vNodes[entry.index], child, childEntry.index, childEntry.primitiveAmount);
+
+			int stackIndex{ stackSize++ };
+			for (; stackIndex > firstStackIndex && aStack[stackIndex - 1].tEntry < childEntry.tEntry; --stackIndex)
+				aStack[stackIndex] = aStack[stackIndex - 1];
+
+			aStack[stackIndex] = childEntry;
 		}
 	}
 
 	return didHit;
 }
 
-inline bool HitTestTriangleMesh(const TriangleMesh& mesh, const Ray& ray)
+//	Same contract as the any hit HitTestBVHLeaves for both wide node layouts
+template<typename WideNode, typename HitTestLeafFunction>
+inline bool HitTestWideNodes(const std::vector<WideNode>& vNodes, const Ray& ray, HitTestLeafFunction hitTestLeaf)
+{
+	if (vNodes.empty())
+		return false;
+
+	const WideRay wideRay{ GetWideRay(ray) };
+
+	struct StackEntry
+	{
+		int
+			index,
+			primitiveAmount;
+	};
+
+	StackEntry aStack[(BVH::WIDTH - 1) * BVH::MAX_DEPTH + 1];
+	aStack[0] = StackEntry(0, 0);
+	int stackSize{ 1 };
+
+	while (stackSize)
+	{
+		const StackEntry entry{ aStack[--stackSize] };
+		if (entry.primitiveAmount)
+		{
+			if (hitTestLeaf(entry.index, entry.primitiveAmount, ray))
+				return true;
+
+			continue;
+		}
+
+		__m128
+			tEntries,
+			tExits;
+
+		int hitMask{ SlabTest(vNodes[entry.index], wideRay, ray.max, tEntries, tExits) };
+		if (!hitMask)
+			continue;
+
+		alignas(16) float aDistances[BVH::WIDTH];
+		_mm_store_ps(aDistances, _mm_sub_ps(tExits, tEntries));
+
+		//	Only the child the ray travels the longest distance through gets moved on top, a full sort doesn't pay off without a closest hit
+		int longestStackIndex{ stackSize };
+		float longestDistance{ -FLT_MAX };
+		while (hitMask)
+		{
+			const int child{ std::countr_zero(static_cast<unsigned int>(hitMask)) };
+			hitMask &= hitMask - 1;
+
+			if (aDistances[child] > longestDistance)
+			{
+				longestDistance = aDistances[child];
+				longestStackIndex = stackSize;
+			}
+
+			StackEntry& childEntry{ aStack[stackSize++] };
+			GetChild(vNodes[entry.index], child, childEntry.index, childEntry.primitiveAmount);
+		}
+
+		std::swap(aStack[longestStackIndex], aStack[stackSize - 1]);
+	}
+
+	return false;
+}
+
+//	The instruction set and the cull mode of the mesh get dispatched once per traversal, its leaves get tested with the matching instantiation
+template<BVHLayout LAYOUT = DEFAULT_BVH_LAYOUT>
+inline bool HitTestTriangleMesh(const TriangleMesh& triangleMesh, const Ray& ray, HitRecord& hitRecord)
+{
+	const BVH& bvh{ triangleMesh.GetGeometry().bvh };
+	const Ray objectSpaceRay{ GetObjectSpaceRay(triangleMesh, ray) };
+
+	return DispatchTriangleLeafKernel(triangleMesh.cullMode,
+		[&triangleMesh, &bvh, &objectSpaceRay, &hitRecord](auto instructionSet, auto cullMode)
+		{
+			const auto hitTestLeaf
+			{
+				[&triangleMesh](int firstIndex, int primitiveAmount, const Ray& ray, HitRecord& hitRecord)
+				{
+					return HitTestTriangleMeshLeaf<decltype(instructionSet)::value, decltype(cullMode)::value>(triangleMesh, firstIndex, primitiveAmount, ray, hitRecord);
+				}
+			};
+
+			//	Geometry whose leaves don't fit the quantized nodes only keeps the full precision ones
+			if constexpr (LAYOUT == BVHLayout::quantized)
+				if (!bvh.GetQuantizedNodes().empty())
+					return HitTestWideNodes(bvh.GetQuantizedNodes(), objectSpaceRay, hitRecord, hitTestLeaf);
+
+			if constexpr (LAYOUT == BVHLayout::binary)
+				return HitTestBVHLeaves(bvh, objectSpaceRay, hitRecord, hitTestLeaf);
+			else
+				return HitTestWideNodes(bvh.GetWideNodes(), objectSpaceRay, hitRecord, hitTestLeaf);
+		});
+}
+
+//	Occlusion test for shadow rays
+template<BVHLayout LAYOUT = DEFAULT_BVH_LAYOUT>
+inline bool HitTestTriangleMesh(const TriangleMesh& triangleMesh, const Ray& ray)
+{
+	const BVH& bvh{ triangleMesh.GetGeometry().bvh };
+	const Ray objectSpaceRay{ GetObjectSpaceRay(triangleMesh, ray) };
+
+	return DispatchTriangleLeafKernel(triangleMesh.cullMode,
+		[&triangleMesh, &bvh, &objectSpaceRay](auto instructionSet, auto cullMode)
+		{
+			const auto hitTestLeaf
+			{
+				[&triangleMesh](int firstIndex, int primitiveAmount, const Ray& ray)
+				{
+					return HitTestTriangleMeshLeaf<decltype(instructionSet)::value, decltype(cullMode)::value>(triangleMesh, firstIndex, primitiveAmount, ray);
+				}
+			};
+
+			if constexpr (LAYOUT == BVHLayout::quantized)
+				if (!bvh.GetQuantizedNodes().empty())
+					return HitTestWideNodes(bvh.GetQuantizedNodes(), objectSpaceRay, hitTestLeaf);
+
+			if constexpr (LAYOUT == BVHLayout::binary)
+				return HitTestBVHLeaves(bvh, objectSpaceRay, hitTestLeaf);
+			else
+				return HitTestWideNodes(bvh.GetWideNodes(), objectSpaceRay, hitTestLeaf);
+		});
+}
+
+//	The rays of laneMask transformed like GetObjectSpaceRay
+inline RayPacket GetObjectSpacePacket(const TriangleMesh& triangleMesh, const RayPacket& packet, int laneMask)
 {
-	HitRecord temporary;
-	return HitTestTriangleMesh(mesh, ray, temporary, true);
+	RayPacket objectSpacePacket{};
+	for (int mask{ laneMask }; mask; mask &= mask - 1)
+	{
+		const int lane{ std::countr_zero(static_cast<unsigned int>(mask)) };
+		objectSpacePacket.SetRay(lane, GetObjectSpaceRay(triangleMesh, packet.GetRay(lane)));
+	}
+
+	return objectSpacePacket;
+}
+
+//	Packet version of HitTestTriangleMesh for the lanes of laneMask, shrinks aMax of the hit lanes and returns their mask
+inline int HitTestTriangleMesh(const TriangleMesh& triangleMesh, RayPacket& packet, int laneMask, HitRecord aHitRecords[])
+{
+	RayPacket objectSpacePacket{ GetObjectSpacePacket(triangleMesh, packet, laneMask) };
+
+	int hitMask{};
+	DispatchTriangleLeafKernel(triangleMesh.cullMode,
+		[&triangleMesh, &objectSpacePacket, aHitRecords, &hitMask](auto instructionSet, auto cullMode)
+		{
+			HitTestBVHLeaves<false>(triangleMesh.GetGeometry().bvh, objectSpacePacket,
+				[&triangleMesh, &objectSpacePacket, aHitRecords, &hitMask](int firstIndex, int primitiveAmount, int laneMask)
+				{
+					for (; laneMask; laneMask &= laneMask - 1)
+					{
+						const int lane{ std::countr_zero(static_cast<unsigned int>(laneMask)) };
+						if (HitTestTriangleMeshLeaf<decltype(instructionSet)::value, decltype(cullMode)::value>(triangleMesh, firstIndex, primitiveAmount, objectSpacePacket.GetRay(lane), aHitRecords[lane]))
+						{
+							objectSpacePacket.aMax[lane] = aHitRecords[lane].t;
+							hitMask |= 1 << lane;
+						}
+					}
+				});
+		});
+
+	for (int mask{ hitMask }; mask; mask &= mask - 1)
+	{
+		const int lane{ std::countr_zero(static_cast<unsigned int>(mask)) };
+		packet.aMax[lane] = aHitRecords[lane].t;
+	}
+
+	return hitMask;
+}
+
+//	Packet occlusion test for the lanes of laneMask, returns the mask of the occluded lanes
+inline int HitTestTriangleMesh(const TriangleMesh& triangleMesh, const RayPacket& packet, int laneMask)
+{
+	RayPacket objectSpacePacket{ GetObjectSpacePacket(triangleMesh, packet, laneMask) };
+	DispatchTriangleLeafKernel(triangleMesh.cullMode,
+		[&triangleMesh, &objectSpacePacket](auto instructionSet, auto cullMode)
+		{
+			HitTestBVHLeaves<true>(triangleMesh.GetGeometry().bvh, objectSpacePacket,
+				[&triangleMesh, &objectSpacePacket](int firstIndex, int primitiveAmount, int laneMask)
+				{
+					for (; laneMask; laneMask &= laneMask - 1)
+					{
+						const int lane{ std::countr_zero(static_cast<unsigned int>(laneMask)) };
+						if (HitTestTriangleMeshLeaf<decltype(instructionSet)::value, decltype(cullMode)::value>(triangleMesh, firstIndex, primitiveAmount, objectSpacePacket.GetRay(lane)))
+							objectSpacePacket.activeMask &= ~(1 << lane);
+					}
+				});
+		});
+
+	return laneMask & ~objectSpacePacket.activeMask;
+}
+
+//	Reference path testing every triangle, kept to benchmark the BVH against
+inline bool HitTestTriangleMeshLinear(const TriangleMesh& triangleMesh, const Ray& ray, HitRecord& hitRecord)
+{
+	float tEntry;
+	if (!SlabTest(AABB(triangleMesh.smallestAABBTransformed, triangleMesh.largestAABBTransformed), ray, GetInverseDirection(ray.direction), tEntry))
+		return false;
+
+	const Ray objectSpaceRay{ GetObjectSpaceRay(triangleMesh, ray) };
+
+	return DispatchCullMode(triangleMesh.cullMode,
+		[&triangleMesh, &objectSpaceRay, &hitRecord](auto cullMode)
+		{
+			bool didHit{};
+			for (int triangleIndex{}; triangleIndex < triangleMesh.GetGeometry().GetTriangleAmount(); ++triangleIndex)
+				if (HitTestTriangleMeshTriangle<decltype(cullMode)::value>(triangleMesh, triangleIndex, objectSpaceRay, hitRecord))
+					didHit = true;
+
+			return didHit;
+		});
+}
+
+inline bool HitTestTriangleMeshLinear(const TriangleMesh& triangleMesh, const Ray& ray)
+{
+	float tEntry;
+	if (!SlabTest(AABB(triangleMesh.smallestAABBTransformed, triangleMesh.largestAABBTransformed), ray, GetInverseDirection(ray.direction), tEntry))
+		return false;
+
+	const Ray objectSpaceRay{ GetObjectSpaceRay(triangleMesh, ray) };
+
+	return DispatchCullMode(triangleMesh.cullMode,
+		[&triangleMesh, &objectSpaceRay](auto cullMode)
+		{
+			for (int triangleIndex{}; triangleIndex < triangleMesh.GetGeometry().GetTriangleAmount(); ++triangleIndex)
+				if (HitTestTriangleMeshTriangle<decltype(cullMode)::value>(triangleMesh, triangleIndex, objectSpaceRay))
+					return true;
+
+			return false;
+		});
 }
 
 inline Vector3 GetDirectionToLight(const Light& light, const Vector3 origin)
@@ -264,6 +1485,18 @@ inline Vector3 GetDirectionToLight(const Light& light, const Vector3 origin)
 	return light.origin - origin;
 }
 
+//	Shadow ray from just above the origin up to the light
+inline Ray GetLightRay(const Light& light, const Vector3& origin)
+{
+	const Vector3 lightVector{ GetDirectionToLight(light, origin) };
+	const float lightVectorMagnitude{ lightVector.GetMagnitude() };
+	const Vector3 lightVectorNormalized{ lightVector / lightVectorMagnitude };
+
+	Ray lightRay{ origin + RAY_EPSILON * lightVectorNormalized, lightVectorNormalized };
+	lightRay.max = lightVectorMagnitude;
+	return lightRay;
+}
+
 inline ColorRGB GetRadiance(const Light& light, const Vector3& target)
 {
 	const Vector3 targetToOrigin{ light.origin - target };
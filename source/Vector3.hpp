@@ -20,6 +20,15 @@ public:
 
 	inline Vector3 GetNormalized() const
 	{
+#ifdef SIMD_MATH
+		const float inverseMagnitude{ _mm_cvtss_f32(GetReciprocalSquareRoot(_mm_set_ss(GetSquareMagnitude()))) };
+		return Vector3
+		(
+			x * inverseMagnitude,
+			y * inverseMagnitude,
+			z * inverseMagnitude
+		);
+#else
 		const float magnitude{ GetMagnitude() };
 		return Vector3
 		(
@@ -27,6 +36,7 @@ public:
 			y / magnitude,
 			z / magnitude
 		);
+#endif
 	}
 
 	inline const Vector3& Normalize()
@@ -0,0 +1,215 @@
+#pragma once
+
+#include "Vector3.hpp"
+
+#ifdef SIMD_MATH
+//	Eight vectors with every component in its own AVX register, the lane-wide counterpart of Vector3 for structure of arrays paths
+struct Vector3x8
+{
+public:
+	static constexpr int WIDTH{ 8 };
+
+	static inline Vector3x8 Load(const float* pX, const float* pY, const float* pZ)
+	{
+		return Vector3x8
+		(
+			_mm256_loadu_ps(pX),
+			_mm256_loadu_ps(pY),
+			_mm256_loadu_ps(pZ)
+		);
+	}
+
+	static inline Vector3x8 Broadcast(const Vector3& vector)
+	{
+		return Vector3x8
+		(
+			_mm256_set1_ps(vector.x),
+			_mm256_set1_ps(vector.y),
+			_mm256_set1_ps(vector.z)
+		);
+	}
+
+	//	Loads eight consecutive Vector3 and deinterleaves them, every 128 bit half holds four of them after the loads
+	static inline Vector3x8 LoadInterleaved(const Vector3* pVectors)
+	{
+		const float* pComponents{ &pVectors->x };
+
+		const __m256
+			vectors04{ _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_loadu_ps(pComponents)), _mm_loadu_ps(pComponents + 12), 1) },
+			vectors15{ _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_loadu_ps(pComponents + 4)), _mm_loadu_ps(pComponents + 16), 1) },
+			vectors26{ _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_loadu_ps(pComponents + 8)), _mm_loadu_ps(pComponents + 20), 1) },
+			xy{ _mm256_shuffle_ps(vectors15, vectors26, _MM_SHUFFLE(2, 1, 3, 2)) },
+			yz{ _mm256_shuffle_ps(vectors04, vectors15, _MM_SHUFFLE(1, 0, 2, 1)) };
+
+		return Vector3x8
+		(
+			_mm256_shuffle_ps(vectors04, xy, _MM_SHUFFLE(2, 0, 3, 0)),
+			_mm256_shuffle_ps(yz, xy, _MM_SHUFFLE(3, 1, 2, 0)),
+			_mm256_shuffle_ps(yz, vectors26, _MM_SHUFFLE(3, 0, 3, 1))
+		);
+	}
+
+	inline void Store(float* pX, float* pY, float* pZ) const
+	{
+		_mm256_storeu_ps(pX, x);
+		_mm256_storeu_ps(pY, y);
+		_mm256_storeu_ps(pZ, z);
+	}
+
+	//	The inverse of LoadInterleaved
+	inline void StoreInterleaved(Vector3* pVectors) const
+	{
+		float* pComponents{ &pVectors->x };
+
+		const __m256
+			xy{ _mm256_shuffle_ps(x, y, _MM_SHUFFLE(2, 0, 2, 0)) },
+			yz{ _mm256_shuffle_ps(y, z, _MM_SHUFFLE(3, 1, 3, 1)) },
+			zx{ _mm256_shuffle_ps(z, x, _MM_SHUFFLE(3, 1, 2, 0)) },
+			vectors04{ _mm256_shuffle_ps(xy, zx, _MM_SHUFFLE(2, 0, 2, 0)) },
+			vectors15{ _mm256_shuffle_ps(yz, xy, _MM_SHUFFLE(3, 1, 2, 0)) },
+			vectors26{ _mm256_shuffle_ps(zx, yz, _MM_SHUFFLE(3, 1, 3, 1)) };
+
+		_mm_storeu_ps(pComponents, _mm256_castps256_ps128(vectors04));
+		_mm_storeu_ps(pComponents + 4, _mm256_castps256_ps128(vectors15));
+		_mm_storeu_ps(pComponents + 8, _mm256_castps256_ps128(vectors26));
+		_mm_storeu_ps(pComponents + 12, _mm256_extractf128_ps(vectors04, 1));
+		_mm_storeu_ps(pComponents + 16, _mm256_extractf128_ps(vectors15, 1));
+		_mm_storeu_ps(pComponents + 20, _mm256_extractf128_ps(vectors26, 1));
+	}
+
+	inline Vector3 GetLane(int lane) const
+	{
+		alignas(32) float aX[WIDTH], aY[WIDTH], aZ[WIDTH];
+		Store(aX, aY, aZ);
+		return Vector3(aX[lane], aY[lane], aZ[lane]);
+	}
+
+	inline __m256 GetSquareMagnitude() const
+	{
+		return Dot(*this, *this);
+	}
+
+	inline __m256 GetMagnitude() const
+	{
+		return _mm256_sqrt_ps(GetSquareMagnitude());
+	}
+
+	inline Vector3x8 GetNormalized() const
+	{
+		return *this * GetReciprocalSquareRoot(GetSquareMagnitude());
+	}
+
+	inline const Vector3x8& Normalize()
+	{
+		*this = GetNormalized();
+		return *this;
+	}
+
+	//	Per lane reciprocal of every component, as the slab tests use it
+	inline Vector3x8 GetReciprocal() const
+	{
+		const __m256 one{ _mm256_set1_ps(1.0f) };
+		return Vector3x8
+		(
+			_mm256_div_ps(one, x),
+			_mm256_div_ps(one, y),
+			_mm256_div_ps(one, z)
+		);
+	}
+
+	static inline __m256 Dot(const Vector3x8& vector1, const Vector3x8& vector2)
+	{
+		return _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(vector1.x, vector2.x), _mm256_mul_ps(vector1.y, vector2.y)), _mm256_mul_ps(vector1.z, vector2.z));
+	}
+
+	static inline Vector3x8 Cross(const Vector3x8& vector1, const Vector3x8& vector2)
+	{
+		return Vector3x8
+		(
+			_mm256_sub_ps(_mm256_mul_ps(vector1.y, vector2.z), _mm256_mul_ps(vector1.z, vector2.y)),
+			_mm256_sub_ps(_mm256_mul_ps(vector1.z, vector2.x), _mm256_mul_ps(vector1.x, vector2.z)),
+			_mm256_sub_ps(_mm256_mul_ps(vector1.x, vector2.y), _mm256_mul_ps(vector1.y, vector2.x))
+		);
+	}
+
+	static inline Vector3x8 Reflect(const Vector3x8& vector1, const Vector3x8& vector2)
+	{
+		return vector1 - vector2 * _mm256_mul_ps(_mm256_set1_ps(2.0f), Dot(vector1, vector2));
+	}
+
+	inline Vector3x8 operator*(__m256 scalars) const
+	{
+		return Vector3x8
+		(
+			_mm256_mul_ps(x, scalars),
+			_mm256_mul_ps(y, scalars),
+			_mm256_mul_ps(z, scalars)
+		);
+	}
+
+	inline Vector3x8 operator*(float scalar) const
+	{
+		return *this * _mm256_set1_ps(scalar);
+	}
+
+	inline Vector3x8 operator/(__m256 scalars) const
+	{
+		return Vector3x8
+		(
+			_mm256_div_ps(x, scalars),
+			_mm256_div_ps(y, scalars),
+			_mm256_div_ps(z, scalars)
+		);
+	}
+
+	inline Vector3x8 operator+(const Vector3x8& vector) const
+	{
+		return Vector3x8
+		(
+			_mm256_add_ps(x, vector.x),
+			_mm256_add_ps(y, vector.y),
+			_mm256_add_ps(z, vector.z)
+		);
+	}
+
+	inline Vector3x8 operator-(const Vector3x8& vector) const
+	{
+		return Vector3x8
+		(
+			_mm256_sub_ps(x, vector.x),
+			_mm256_sub_ps(y, vector.y),
+			_mm256_sub_ps(z, vector.z)
+		);
+	}
+
+	inline Vector3x8 operator-() const
+	{
+		const __m256 signMask{ _mm256_set1_ps(-0.0f) };
+		return Vector3x8
+		(
+			_mm256_xor_ps(x, signMask),
+			_mm256_xor_ps(y, signMask),
+			_mm256_xor_ps(z, signMask)
+		);
+	}
+
+	inline Vector3x8& operator+=(const Vector3x8& vector)
+	{
+		*this = *this + vector;
+		return *this;
+	}
+
+	inline Vector3x8& operator-=(const Vector3x8& vector)
+	{
+		*this = *this - vector;
+		return *this;
+	}
+
+	__m256
+		x,
+		y,
+		z;
+};
+
+static_assert(sizeof(Vector3) == 3 * sizeof(float), "Vector3x8::LoadInterleaved expects tightly packed Vector3 arrays");
+#endif
\ No newline at end of file
@@ -2,12 +2,18 @@
 
 #include <cmath>
 
+#include "SIMD.hpp"
+
 struct Vector4
 {
 public:
 	inline float GetSquareMagnitude() const
 	{
+#ifdef SIMD_MATH
+		return Dot(*this, *this);
+#else
 		return x * x + y * y + z * z + w * w;
+#endif
 	}
 
 	inline float GetMagnitude() const
@@ -18,6 +24,9 @@ public:
 	inline Vector4 GetNormalized() const
 	{
 		const float magnitude{ GetMagnitude() };
+#ifdef SIMD_MATH
+		return *this / magnitude;
+#else
 		return Vector4
 		(
 			x / magnitude,
@@ -25,6 +34,7 @@ public:
 			z / magnitude,
 			w / magnitude
 		);
+#endif
 	}
 
 	inline const Vector4& Normalize()
@@ -35,11 +45,36 @@ public:
 
 	static inline float Dot(const Vector4& vector1, const Vector4& vector2)
 	{
+#ifdef SIMD_MATH
+		const __m128
+			product{ _mm_mul_ps(vector1.Load(), vector2.Load()) },
+			sum{ _mm_add_ps(product, _mm_movehl_ps(product, product)) };
+
+		return _mm_cvtss_f32(_mm_add_ss(sum, _mm_shuffle_ps(sum, sum, _MM_SHUFFLE(1, 1, 1, 1))));
+#else
 		return vector1.x * vector2.x + vector1.y * vector2.y + vector1.z * vector2.z + vector1.w * vector2.w;
+#endif
+	}
+
+#ifdef SIMD_MATH
+	inline __m128 Load() const
+	{
+		return _mm_loadu_ps(&x);
+	}
+
+	static inline Vector4 Store(__m128 components)
+	{
+		Vector4 result;
+		_mm_storeu_ps(&result.x, components);
+		return result;
 	}
+#endif
 
 	inline Vector4 operator*(float scalar) const
 	{
+#ifdef SIMD_MATH
+		return Store(_mm_mul_ps(Load(), _mm_set1_ps(scalar)));
+#else
 		return Vector4
 		(
 			x * scalar,
@@ -47,10 +82,14 @@ public:
 			z * scalar,
 			w * scalar
 		);
+#endif
 	}
 
 	inline Vector4 operator/(float scalar) const
 	{
+#ifdef SIMD_MATH
+		return Store(_mm_div_ps(Load(), _mm_set1_ps(scalar)));
+#else
 		return Vector4
 		(
 			x / scalar,
@@ -58,10 +97,14 @@ public:
 			z / scalar,
 			w / scalar
 		);
+#endif
 	}
 
 	inline Vector4 operator+(const Vector4& vector) const
 	{
+#ifdef SIMD_MATH
+		return Store(_mm_add_ps(Load(), vector.Load()));
+#else
 		return Vector4
 		(
 			x + vector.x,
@@ -69,10 +112,14 @@ public:
 			z + vector.z,
 			w + vector.w
 		);
+#endif
 	}
 
 	inline Vector4 operator-(const Vector4& vector) const
 	{
+#ifdef SIMD_MATH
+		return Store(_mm_sub_ps(Load(), vector.Load()));
+#else
 		return Vector4
 		(
 			x - vector.x,
@@ -80,41 +127,58 @@ public:
 			z - vector.z,
 			w - vector.w
 		);
+#endif
 	}
 
 	inline Vector4& operator*=(float scalar)
 	{
+#ifdef SIMD_MATH
+		_mm_storeu_ps(&x, _mm_mul_ps(Load(), _mm_set1_ps(scalar)));
+#else
 		x *= scalar;
 		y *= scalar;
 		z *= scalar;
 		w *= scalar;
+#endif
 		return *this;
 	}
 
 	inline Vector4& operator/=(float scalar)
 	{
+#ifdef SIMD_MATH
+		_mm_storeu_ps(&x, _mm_div_ps(Load(), _mm_set1_ps(scalar)));
+#else
 		x /= scalar;
 		y /= scalar;
 		z /= scalar;
 		w /= scalar;
+#endif
 		return *this;
 	}
 
 	inline Vector4& operator+=(const Vector4& vector)
 	{
+#ifdef SIMD_MATH
+		_mm_storeu_ps(&x, _mm_add_ps(Load(), vector.Load()));
+#else
 		x += vector.x;
 		y += vector.y;
 		z += vector.z;
 		w += vector.w;
+#endif
 		return *this;
 	}
 
 	inline Vector4& operator-=(const Vector4& vector)
 	{
+#ifdef SIMD_MATH
+		_mm_storeu_ps(&x, _mm_sub_ps(Load(), vector.Load()));
+#else
 		x -= vector.x;
 		y -= vector.y;
 		z -= vector.z;
 		w -= vector.w;
+#endif
 		return *this;
 	}
 
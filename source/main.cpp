@@ -6,7 +6,9 @@
 #include "Timer.h"
 #include "Renderer.h"
 #include "Scene.h"
+#include "Benchmark.h"
 #include "Constants.hpp"
+#include "InstructionSet.hpp"
 
 void ShutDown(SDL_Window* pWindow)
 {
@@ -14,15 +16,19 @@ void ShutDown(SDL_Window* pWindow)
 	SDL_Quit();
 }
 
-int main([[maybe_unused]] int argc, [[maybe_unused]] char* args[])
+int main(int argc, char* args[])
 {
+	//	Runs the SIMD math checks without opening a window, the exit code tells whether they passed
+	if (argc > 1 && std::string(args[1]) == "--check-simd-math")
+		return CheckSIMDMath(std::cout) ? 0 : 1;
+
 	SDL_Init(SDL_INIT_VIDEO);
 
 	const uint32_t 
 		width{ 640 },
 		height{ 480 };
 
-	const std::string title{ "RayTracer - Jakub Fratczak (2DAE10)" };
+	const std::string title{ std::string("RayTracer - Jakub Fratczak (2DAE10) - ") + GetInstructionSetName(GetInstructionSet()) };
 	SDL_Window* pWindow = SDL_CreateWindow(
 		title.c_str(),
 		SDL_WINDOWPOS_UNDEFINED,
@@ -34,20 +40,43 @@ int main([[maybe_unused]] int argc, [[maybe_unused]] char* args[])
 
 	SDL_SetRelativeMouseMode(SDL_bool(true));
 
-	Scene* const pScene =
-		//new SceneWeek1();
-		//new SceneWeek2();
-		//new SceneWeek3();
-		new SceneWeek4();
-		//new SceneWeek4Bunny();
-		//new SceneExtra();
+	const auto createScene
+	{
+		[]() -> Scene*
+		{
+			return
+				//new SceneWeek1();
+				//new SceneWeek2();
+				//new SceneWeek3();
+				new SceneWeek4();
+				//new SceneWeek4Bunny();
+				//new SceneExtra();
+		}
+	};
+
+	//	The scene gets double buffered: while one frame gets rendered, the other instance gets updated to the next frame.
+	//	The objects are animated by the total time, so the instances don't share any state
+	Scene
+		* pScene{ createScene() },
+		* pNextScene{ createScene() };
+
+	//	The main thread keeps sampling the input while a frame gets rendered, the render thread latches the newest camera
+	static constexpr int INPUT_SAMPLING_INTERVAL_MILLISECONDS{ 1 };
+	Camera camera{ pScene->GetCamera() };
+	CameraLatch cameraLatch{ camera };
 
 	Renderer renderer{ pWindow, pScene };
+	renderer.SetCameraLatch(&cameraLatch);
 
 	std::cout << CONTROLS;
 
-	Timer timer{};
+	Timer
+		timer{},
+		inputTimer{};
+
 	timer.Start();
+	inputTimer.Start();
+	pScene->Update(timer);
 
 	bool
 		isLooping{ true },
@@ -70,7 +99,7 @@ int main([[maybe_unused]] int argc, [[maybe_unused]] char* args[])
 				case SDL_SCANCODE_X:
 					takeScreenshot = true;
 					break;
-#ifdef REFLECT
+
 				case SDL_SCANCODE_UP:
 					renderer.IncrementReflectionBounceAmount(1);
 					break;
@@ -78,7 +107,27 @@ int main([[maybe_unused]] int argc, [[maybe_unused]] char* args[])
 				case SDL_SCANCODE_DOWN:
 					renderer.IncrementReflectionBounceAmount(-1);
 					break;
-#endif
+
+				case SDL_SCANCODE_F4:
+					renderer.ToggleWavefront();
+					break;
+
+				case SDL_SCANCODE_F5:
+					renderer.ToggleReflections();
+					break;
+
+				case SDL_SCANCODE_F8:
+					renderer.CycleSampler();
+					break;
+
+				case SDL_SCANCODE_F9:
+					renderer.ToggleSkippingUnchangedFrames();
+					break;
+
+				case SDL_SCANCODE_F10:
+					renderer.ToggleInteractivePreview();
+					break;
+
 				case SDL_SCANCODE_F2:
 					renderer.ToggleShadows();
 					break;
@@ -90,31 +139,40 @@ int main([[maybe_unused]] int argc, [[maybe_unused]] char* args[])
 				case SDL_SCANCODE_F6:
 					timer.StartBenchmark();
 					break;
+
+				case SDL_SCANCODE_F7:
+					pScene->GetCamera() = camera;
+					RunAccelerationBenchmark(*pScene);
+					break;
 				}
 				break;
 
+			case SDL_WINDOWEVENT:
+				if (event.window.event == SDL_WINDOWEVENT_EXPOSED)
+					renderer.InvalidateWindow();
+				break;
+
 			case SDL_MOUSEWHEEL:
-				pScene->GetCamera().IncrementFieldOfViewAngle(-float(event.wheel.y) / 20.0f);
-#ifdef REFLECT
-				renderer.ResetAccumulatedReflectionData();
-#endif
+				camera.IncrementFieldOfViewAngle(-float(event.wheel.y) / 20.0f);
+				cameraLatch.Store(camera);
 				break;
 			}
 		}
 
-		pScene->Update(timer);
-#ifdef REFLECT
-		if (pScene->GetCamera().DidMove())
-			renderer.ResetAccumulatedReflectionData();
-#endif
+		renderer.SetScene(pScene);
+		renderer.BeginRender();
+
+		//	Overlaps with the rendering: presenting the previous frame and updating the scene of the next one
+		if (renderer.Present())
+			timer.AddInputLatency(renderer.GetInputLatency());
 
-		renderer.Render();
 		timer.Update();
 		printTimer += timer.GetElapsed();
 		if (printTimer >= 1.0f)
 		{
 			printTimer = 0.0f;
-			SDL_SetWindowTitle(pWindow, (title + " - dFPS: " + std::to_string(timer.GetdFPS())).c_str());
+			SDL_SetWindowTitle(pWindow, (title + " - dFPS: " + std::to_string(timer.GetdFPS()) +
+				" - Input Latency: " + std::to_string(timer.GetInputLatency() * 1000.0f) + " ms (max " + std::to_string(timer.GetMaxInputLatency() * 1000.0f) + " ms)").c_str());
 		}
 
 		if (takeScreenshot)
@@ -140,11 +198,27 @@ int main([[maybe_unused]] int argc, [[maybe_unused]] char* args[])
 
 			takeScreenshot = false;
 		}
+
+		pNextScene->Update(timer);
+
+		//	Until the frame is done, so a slow frame doesn't delay the input the next one gets rendered with
+		do
+		{
+			SDL_PumpEvents();
+			inputTimer.Update();
+			camera.Update(inputTimer);
+			cameraLatch.Store(camera);
+		} while (!renderer.WaitForRender(INPUT_SAMPLING_INTERVAL_MILLISECONDS));
+
+		renderer.EndRender();
+
+		std::swap(pScene, pNextScene);
 	}
 
 	timer.Stop();
 
 	delete pScene;
+	delete pNextScene;
 	ShutDown(pWindow);
 	return 0;
 }
\ No newline at end of file